@@ -0,0 +1,410 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "batch.h"
+
+#include "../core/core8080.h"
+#include "../core/io8080.h"
+#include "../core/sched8080.h"
+#include "../core/video8080.h"
+#include "../core/util.h"
+#include "../core/jit8080.h"
+#include "../core/block8080.h"
+#include "../core/recomp8080.h"
+#include "../core/rom8080.h"
+#include "../core/shift8080.h"
+
+#define MEMORY_SIZE 0x10000
+#define LINE_LENGTH 4096
+
+// every job on the same rom maps the same open files
+struct image {
+    char *path;
+    struct rom_8080 *rom;
+    struct image *next;
+};
+
+struct input_step {
+    uint64_t cycle;
+    uint8_t port;
+    uint8_t value;
+};
+
+struct job {
+    char *rom;
+    uint64_t budget;
+    struct image *image;
+    struct input_step *inputs;
+    int n_inputs;
+    int next_input;
+    int failed; // the machine could not be set up, there is no result
+
+    // only while running
+    struct state_8080 *state;
+    struct scheduler_8080 *sched;
+    struct shift_register_8080 shifter;
+
+    struct batch_result result;
+};
+
+// a worker's machines. the owner takes from the front and puts back at the end, so its
+// machines take turns. an idle worker steals from the end of someone else's
+struct deque {
+    pthread_mutex_t lock;
+    struct job *jobs[BATCH_INSTANCES_PER_WORKER + 1];
+    int head;
+    atomic_int count; // written under the lock, read without it to pick work
+};
+
+struct batch;
+
+struct worker {
+    pthread_t thread;
+    struct deque deque;
+    struct batch *batch;
+    int index;
+};
+
+struct batch {
+    struct job *jobs;
+    int n_jobs;
+    atomic_int next_job; // first job no worker has started
+    atomic_int remaining;
+    struct worker workers[BATCH_MAX_WORKERS];
+    int n_workers;
+    int jit;
+    int blocks;
+};
+
+static int skip_line(const char *line) {
+    while (*line == ' ' || *line == '\t') line++;
+    return *line == '#' || *line == '\n' || *line == '\r' || *line == '\0';
+}
+
+static struct image *load_image(struct image **images, const char *path) {
+    for (struct image *image = *images; image; image = image->next) {
+        if (strcmp(image->path, path) == 0) return image;
+    }
+
+    struct rom_8080 *rom = open_rom(path);
+    if (rom == NULL) return NULL;
+
+    struct image *image = calloc(1, sizeof(struct image));
+    image->rom = rom;
+    image->path = strdup(path);
+    image->next = *images;
+    *images = image;
+    return image;
+}
+
+static int load_script(struct job *job, const char *path) {
+    char line[LINE_LENGTH];
+    FILE *fd = fopen(path, "r");
+    int capacity = 0;
+
+    if (fd == NULL) return -1;
+    while (fgets(line, sizeof(line), fd)) {
+        unsigned long long frame;
+        int port, value;
+
+        if (skip_line(line)) continue;
+        if (sscanf(line, "%llu %i %i", &frame, &port, &value) != 3 || port < 0 || port > 0xff || value < 0 ||
+            value > 0xff) {
+            fclose(fd);
+            return -1;
+        }
+        if (job->n_inputs == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            job->inputs = realloc(job->inputs, capacity * sizeof(struct input_step));
+        }
+        job->inputs[job->n_inputs].cycle = frame * CYCLES_PER_FRAME;
+        job->inputs[job->n_inputs].port = port;
+        job->inputs[job->n_inputs].value = value;
+        job->n_inputs++;
+    }
+    fclose(fd);
+    return 0;
+}
+
+static int load_jobs(struct batch *batch, struct image **images, const char *job_file) {
+    char line[LINE_LENGTH], rom[LINE_LENGTH], script[LINE_LENGTH];
+    FILE *fd = fopen(job_file, "r");
+    int capacity = 0, number = 0;
+
+    if (fd == NULL) {
+        printf("Cannot Open Job File %s\n", job_file);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fd)) {
+        unsigned long long budget;
+        int fields;
+
+        number++;
+        if (skip_line(line)) continue;
+        fields = sscanf(line, "%4095s %llu %4095s", rom, &budget, script);
+        if (fields < 2) {
+            printf("%s:%d: Expected rom cycles [input_script]\n", job_file, number);
+            fclose(fd);
+            return -1;
+        }
+        if (batch->n_jobs == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            batch->jobs = realloc(batch->jobs, capacity * sizeof(struct job));
+        }
+
+        struct job *job = &batch->jobs[batch->n_jobs];
+        memset(job, 0, sizeof(struct job));
+        job->rom = strdup(rom);
+        job->budget = budget;
+        job->image = load_image(images, rom);
+        // counted straight away, so free_batch frees whatever it holds should it fail
+        batch->n_jobs++;
+        if (job->image == NULL) {
+            printf("%s:%d: Cannot Open Rom %s\n", job_file, number, rom);
+            fclose(fd);
+            return -1;
+        }
+        if (fields == 3 && load_script(job, script)) {
+            printf("%s:%d: Cannot Read Input Script %s\n", job_file, number, script);
+            fclose(fd);
+            return -1;
+        }
+    }
+    fclose(fd);
+    return 0;
+}
+
+// -1 when the machine cannot be set up, nothing of it is left allocated then
+static int start_job(struct job *job, int jit, int blocks) {
+    job->state = make_state(MEMORY_SIZE, 0);
+    if (job->state == NULL) return -1;
+    job->state->io = make_io(256);
+    job->sched = make_scheduler();
+    if (rom8080_load(job->image->rom, job->state) || job->state->io == NULL || job->sched == NULL) {
+        if (job->state->io) free_io(job->state->io);
+        free(job->sched);
+        free_state(job->state);
+        job->state = NULL;
+        job->sched = NULL;
+        return -1;
+    }
+    shift8080_install(job->state->io, &job->shifter);
+    video8080_install_interrupts(job->sched, job->state);
+    if (jit) job->state->jit = make_jit();
+    if (blocks) job->state->blocks = make_block_cache();
+    job->state->recomp = make_recomp(job->state->memory);
+    return 0;
+}
+
+// collects the result and frees the machine, returns 1 once the job is done.
+// a slice ends early at the next scripted input so every run sees it at the same cycle
+static int run_slice(struct job *job) {
+    struct state_8080 *state = job->state;
+    uint64_t end = state->cycles + BATCH_SLICE_CYCLES;
+    int halted;
+
+    while (job->next_input < job->n_inputs && job->inputs[job->next_input].cycle <= state->cycles) {
+        struct input_step *step = &job->inputs[job->next_input++];
+        io8080_write_port(state->io, step->port, step->value);
+    }
+    if (job->next_input < job->n_inputs && job->inputs[job->next_input].cycle < end) {
+        end = job->inputs[job->next_input].cycle;
+    }
+    if (end > job->budget) end = job->budget;
+
+    halted = cpu_run_scheduled(state, job->sched, end > state->cycles ? end - state->cycles : 0);
+    if (!halted && state->cycles < job->budget) return 0;
+
+    struct batch_result *result = &job->result;
+    result->a = state->a;
+    result->b = state->b;
+    result->c = state->c;
+    result->d = state->d;
+    result->e = state->e;
+    result->h = state->h;
+    result->l = state->l;
+    result->psw = pack_flags(state);
+    result->sp = state->sp;
+    result->pc = state->pc;
+    result->halted = halted;
+    result->cycles = state->cycles;
+    result->memory_hash = hash_bytes(state->memory, MEMORY_SIZE);
+    result->frame_hash = hash_bytes(state->memory + VRAM_ADDRESS, VRAM_SIZE);
+
+    free(job->sched);
+    if (state->jit) free_jit(state->jit);
+    if (state->blocks) free_block_cache(state->blocks);
+    if (state->recomp) free_recomp(state->recomp);
+    free_io(state->io);
+    free_state(state);
+    job->state = NULL;
+    job->sched = NULL;
+    return 1;
+}
+
+static void deque_push(struct deque *deque, struct job *job) {
+    pthread_mutex_lock(&deque->lock);
+    deque->jobs[(deque->head + deque->count) % (BATCH_INSTANCES_PER_WORKER + 1)] = job;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+static struct job *deque_pop_front(struct deque *deque) {
+    struct job *job = NULL;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        job = deque->jobs[deque->head];
+        deque->head = (deque->head + 1) % (BATCH_INSTANCES_PER_WORKER + 1);
+        deque->count--;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return job;
+}
+
+static struct job *deque_pop_back(struct deque *deque) {
+    struct job *job = NULL;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        deque->count--;
+        job = deque->jobs[(deque->head + deque->count) % (BATCH_INSTANCES_PER_WORKER + 1)];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return job;
+}
+
+// reading count without the lock only picks the victim, the pop itself is locked
+static struct job *steal(struct worker *thief) {
+    struct batch *batch = thief->batch;
+
+    for (int i = 1; i < batch->n_workers; i++) {
+        struct worker *victim = &batch->workers[(thief->index + i) % batch->n_workers];
+        if (atomic_load_explicit(&victim->deque.count, memory_order_relaxed) == 0) continue;
+
+        struct job *job = deque_pop_back(&victim->deque);
+        if (job) return job;
+    }
+    return NULL;
+}
+
+static struct job *claim(struct batch *batch) {
+    int next = atomic_fetch_add(&batch->next_job, 1);
+    if (next >= batch->n_jobs) return NULL;
+
+    struct job *job = &batch->jobs[next];
+    if (start_job(job, batch->jit, batch->blocks)) {
+        job->failed = 1;
+        atomic_fetch_sub(&batch->remaining, 1);
+        return NULL;
+    }
+    return job;
+}
+
+static void *work(void *data) {
+    struct worker *worker = data;
+    struct batch *batch = worker->batch;
+    struct timespec idle = {0, 100000};
+
+    while (atomic_load(&batch->remaining) > 0) {
+        struct job *job = NULL;
+
+        // keep a few machines going, so a stalled one never leaves the core idle
+        if (atomic_load_explicit(&worker->deque.count, memory_order_relaxed) < BATCH_INSTANCES_PER_WORKER) job = claim(batch);
+        if (job == NULL) job = deque_pop_front(&worker->deque);
+        if (job == NULL) job = steal(worker);
+        if (job == NULL) {
+            // everything left is being run by other workers, check back in a bit
+            nanosleep(&idle, NULL);
+            continue;
+        }
+
+        if (run_slice(job)) atomic_fetch_sub(&batch->remaining, 1);
+        else deque_push(&worker->deque, job);
+    }
+    return NULL;
+}
+
+static int count_cores() {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) return 1;
+    return cores > BATCH_MAX_WORKERS ? BATCH_MAX_WORKERS : (int) cores;
+}
+
+static void free_batch(struct batch *batch, struct image *images) {
+    for (int i = 0; i < batch->n_jobs; i++) {
+        free(batch->jobs[i].rom);
+        free(batch->jobs[i].inputs);
+    }
+    while (images) {
+        struct image *next = images->next;
+        free(images->path);
+        close_rom(images->rom);
+        free(images);
+        images = next;
+    }
+    free(batch->jobs);
+    free(batch);
+}
+
+int run_batch(char *job_file, int debug, int jit, int blocks) {
+    struct batch *batch = calloc(1, sizeof(struct batch));
+    struct image *images = NULL;
+    struct timespec start, end;
+
+    if (load_jobs(batch, &images, job_file)) {
+        free_batch(batch, images);
+        return 1;
+    }
+
+    batch->n_workers = count_cores();
+    batch->jit = jit;
+    batch->blocks = blocks;
+    atomic_init(&batch->next_job, 0);
+    atomic_init(&batch->remaining, batch->n_jobs);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < batch->n_workers; i++) {
+        struct worker *worker = &batch->workers[i];
+        worker->batch = batch;
+        worker->index = i;
+        pthread_mutex_init(&worker->deque.lock, NULL);
+        pthread_create(&worker->thread, NULL, work, worker);
+    }
+    for (int i = 0; i < batch->n_workers; i++) {
+        pthread_join(batch->workers[i].thread, NULL);
+        pthread_mutex_destroy(&batch->workers[i].deque.lock);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    int failed = 0;
+    for (int i = 0; i < batch->n_jobs; i++) {
+        struct job *job = &batch->jobs[i];
+        struct batch_result *result = &job->result;
+
+        if (job->failed) {
+            printf("%s %llu: failed, cannot load the rom\n", job->rom, (unsigned long long) job->budget);
+            failed = 1;
+            continue;
+        }
+
+        printf("%s %llu: a=%02x b=%02x c=%02x d=%02x e=%02x h=%02x l=%02x psw=%02x sp=%04x pc=%04x "
+               "cycles=%llu halted=%d memory=%016llx frame=%016llx\n",
+               job->rom, (unsigned long long) job->budget, result->a, result->b, result->c, result->d,
+               result->e, result->h, result->l, result->psw, result->sp, result->pc,
+               (unsigned long long) result->cycles, result->halted,
+               (unsigned long long) result->memory_hash, (unsigned long long) result->frame_hash);
+    }
+    if (debug) {
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%d jobs on %d workers in %.3fs\n", batch->n_jobs, batch->n_workers, seconds);
+    }
+
+    free_batch(batch, images);
+    return failed;
+}
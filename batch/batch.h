@@ -0,0 +1,30 @@
+#ifndef EMULATOR101_BATCH_H
+#define EMULATOR101_BATCH_H
+
+#include <stdint.h>
+
+#define BATCH_MAX_WORKERS 256
+#define BATCH_INSTANCES_PER_WORKER 4 // machines a worker round-robins between
+#define BATCH_SLICE_CYCLES CYCLES_PER_FRAME
+
+struct batch_result {
+    uint8_t a, b, c, d, e, h, l;
+    uint8_t psw;
+    uint16_t sp;
+    uint16_t pc;
+    int halted;
+    uint64_t cycles;
+    uint64_t memory_hash;
+    uint64_t frame_hash; // of the vram
+};
+
+// runs every job of job_file on a work stealing pool with a worker per core and prints a
+// result line per job, in job file order. with jit or blocks set every machine gets its own
+// code cache or block cache.
+// job_file has a "rom cycles [input_script]" line per job, input scripts a "frame port value"
+// line per port write, port and value 0-255. blank lines and lines starting with # are
+// skipped in both. a job whose machine cannot be set up gets a failed line, and run_batch
+// then returns 1
+int run_batch(char *job_file, int debug, int jit, int blocks);
+
+#endif //EMULATOR101_BATCH_H
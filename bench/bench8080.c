@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core/core8080.h"
+#include "core/run8080.h"
+#include "core/io8080.h"
+#include "core/jit8080.h"
+#include "core/block8080.h"
+#include "core/rom8080.h"
+
+// bench8080 [rom] [instructions]
+// runs the rom (or the built in kernel) through cpu_run and reports instructions per second,
+// then from pre-decoded blocks and again with the jit where the host has one.
+// `make bench` builds it once with eager and once with lazy flags
+
+#define RUN_BATCH 4096
+
+// alu heavy loop over a 256 byte buffer, shaped like the game loops: loads, adds, compares,
+// conditional jumps and a call per iteration
+static uint8_t kernel[] = {
+        0x26, 0xf0,             // 0000 MVI H, f0
+        0x2e, 0x00,             // 0002 MVI L, 00
+        0xf9,                   // 0004 SPHL
+        0x26, 0x20,             // 0005 MVI H, 20
+        0x2e, 0x00,             // 0007 MVI L, 00
+        0x06, 0x00,             // 0009 MVI B, 00
+        0x7e,                   // 000b MOV A, M
+        0x81,                   // 000c ADD C
+        0x4f,                   // 000d MOV C, A
+        0xaa,                   // 000e XRA D
+        0x77,                   // 000f MOV M, A
+        0x23,                   // 0010 INX H
+        0x14,                   // 0011 INR D
+        0xfe, 0x80,             // 0012 CPI 80
+        0xda, 0x18, 0x00,       // 0014 JC 0018
+        0x1c,                   // 0017 INR E
+        0xcd, 0x30, 0x00,       // 0018 CALL 0030
+        0x05,                   // 001b DCR B
+        0xc2, 0x0b, 0x00,       // 001c JNZ 000b
+        0xc3, 0x05, 0x00,       // 001f JMP 0005
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x93,                   // 0030 SUB E
+        0xb3,                   // 0031 ORA E
+        0x9a,                   // 0032 SBB D
+        0xc8,                   // 0033 RZ
+        0x3c,                   // 0034 INR A
+        0xc9,                   // 0035 RET
+};
+
+static void measure(struct state_8080 *state, long instructions, int blocks, int jit) {
+    struct timespec start, end;
+    long executed = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (executed < instructions) {
+        int batch = instructions - executed < RUN_BATCH ? (int) (instructions - executed) : RUN_BATCH;
+        executed += batch;
+        if (cpu_run(state, batch)) break;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+#ifdef LAZY_FLAGS
+    const char *mode = "lazy";
+#else
+    const char *mode = "eager";
+#endif
+    printf("%-5s flags%s: %ld instructions in %.3fs, %.1f MIPS (a=%x)\n",
+           mode, jit ? ", jit" : blocks ? ", blocks" : "", executed, seconds, executed / seconds / 1e6, state->a);
+}
+
+static void bench(char *rom, long instructions, int blocks, int jit) {
+    struct state_8080 *state = make_state(0x10000, 0);
+
+    if (state == NULL) {
+        printf("Cannot Allocate Memory\n");
+        return;
+    }
+    state->io = make_io(256);
+
+    int loaded = rom == NULL || load_rom(state, rom) == 0;
+    if (rom == NULL) memcpy(state->memory, kernel, sizeof(kernel));
+    state->pc = 0;
+    state->sp = 0xf000;
+    if (blocks) state->blocks = make_block_cache();
+    if (jit) state->jit = make_jit();
+
+    if (!loaded) printf("Cannot Load ROM %s\n", rom);
+    else if (jit && state->jit == NULL) printf("No JIT On This Host\n");
+    else measure(state, instructions, blocks, jit);
+
+    if (state->jit) free_jit(state->jit);
+    if (state->blocks) free_block_cache(state->blocks);
+    free_io(state->io);
+    free_state(state);
+}
+
+int main(int argc, char *argv[]) {
+    char *rom = argc > 1 ? argv[1] : NULL;
+    long instructions = argc > 2 ? atol(argv[2]) : 200000000L;
+
+    bench(rom, instructions, 0, 0);
+    bench(rom, instructions, 1, 0);
+    bench(rom, instructions, 0, 1);
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/core8080.h"
+#include "core/run8080.h"
+#include "core/io8080.h"
+#include "core/jit8080.h"
+#include "core/block8080.h"
+#include "core/recomp8080.h"
+#include "core/profile8080.h"
+#include "core/rom8080.h"
+#include "core/sched8080.h"
+#include "core/shift8080.h"
+#include "core/video8080.h"
+#include "core/util.h"
+
+// check8080 rom [frames]
+// plays the rom for frames frames with its interrupts and scripted inputs through every
+// engine and checks they end on the cycles, registers and memory of the switch interpreter.
+// the recompiled engine takes part when this binary has a translation of the rom.
+// `make check ROM=rom` builds it with eager and with lazy flags, exits 1 on a mismatch
+
+enum engine {
+    ENGINE_SWITCH,
+    ENGINE_THREADED,
+    ENGINE_BLOCKS,
+    ENGINE_JIT,
+    ENGINE_RECOMP,
+    ENGINES
+};
+
+static const char *engine_names[ENGINES] = {"switch", "threaded", "blocks", "jit", "recomp"};
+
+struct result {
+    uint8_t a, b, c, d, e, h, l, psw;
+    uint16_t sp, pc;
+    uint8_t int_enable, halted;
+    uint64_t cycles;
+    uint64_t memory_hash;
+};
+
+// coin, start, then fire and moves on a pattern, so the game gets past its attract mode
+static uint8_t inputs(int frame) {
+    uint8_t port = 0x08;
+
+    if (frame > 100 && frame < 110) port |= 0x01;
+    if (frame > 150 && frame < 160) port |= 0x04;
+    if (frame > 200 && (frame / 37) % 2) port |= 0x10;
+    if (frame > 400 && (frame / 13) % 3 == 1) port |= 0x20;
+    if (frame > 400 && (frame / 17) % 3 == 2) port |= 0x40;
+    return port;
+}
+
+// 0 when the engine is not available on this host or in this binary
+static int play(char *rom, int frames, enum engine engine, struct result *result) {
+    struct state_8080 *state = make_state(0x10000, 0);
+    struct shift_register_8080 shifter;
+
+    if (state == NULL || load_rom(state, rom)) {
+        fprintf(stderr, "cannot load %s\n", rom);
+        exit(1);
+    }
+    memory8080_invaders(state);
+    state->io = make_io(256);
+    shift8080_install(state->io, &shifter);
+
+    // cpu_run steps the switch interpreter while it profiles
+    if (engine == ENGINE_SWITCH) state->profile = make_profile();
+    if (engine == ENGINE_BLOCKS) state->blocks = make_block_cache();
+    if (engine == ENGINE_JIT) state->jit = make_jit();
+    if (engine == ENGINE_RECOMP) state->recomp = make_recomp(state->memory);
+
+    int available = (engine != ENGINE_JIT || state->jit) && (engine != ENGINE_RECOMP || state->recomp);
+    if (available) {
+        struct scheduler_8080 *sched = make_scheduler();
+        video8080_install_interrupts(sched, state);
+        for (int frame = 0; frame < frames; frame++) {
+            io8080_write_port(state->io, 1, inputs(frame));
+            cpu_run_scheduled(state, sched, CYCLES_PER_FRAME);
+        }
+        free(sched);
+
+        memset(result, 0, sizeof(*result));
+        result->a = state->a;
+        result->b = state->b;
+        result->c = state->c;
+        result->d = state->d;
+        result->e = state->e;
+        result->h = state->h;
+        result->l = state->l;
+        result->psw = pack_flags(state);
+        result->sp = state->sp;
+        result->pc = state->pc;
+        result->int_enable = state->int_enable;
+        result->halted = state->halted;
+        result->cycles = state->cycles;
+        result->memory_hash = hash_bytes(state->memory, MEMORY_HOST_SIZE);
+    }
+
+    if (state->profile) free(state->profile);
+    if (state->blocks) free_block_cache(state->blocks);
+    if (state->jit) free_jit(state->jit);
+    if (state->recomp) free_recomp(state->recomp);
+    free_io(state->io);
+    free_state(state);
+    return available;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s rom [frames]\n", argv[0]);
+        return 1;
+    }
+    int frames = argc > 2 ? atoi(argv[2]) : 3000;
+    struct result reference, result;
+    int failed = 0;
+
+#ifdef LAZY_FLAGS
+    const char *mode = "lazy";
+#else
+    const char *mode = "eager";
+#endif
+    play(argv[1], frames, ENGINE_SWITCH, &reference);
+    printf("%-5s flags, %d frames: switch pc=%04x cycles=%lu memory=%016lx\n", mode, frames, reference.pc,
+           (unsigned long) reference.cycles, (unsigned long) reference.memory_hash);
+
+    for (int engine = ENGINE_THREADED; engine < ENGINES; engine++) {
+        if (!play(argv[1], frames, engine, &result)) {
+            printf("  %-8s not available\n", engine_names[engine]);
+            continue;
+        }
+        int same = memcmp(&reference, &result, sizeof(result)) == 0;
+        printf("  %-8s %s", engine_names[engine], same ? "ok" : "MISMATCH");
+        if (!same) {
+            printf(" pc=%04x cycles=%lu memory=%016lx", result.pc, (unsigned long) result.cycles,
+                   (unsigned long) result.memory_hash);
+        }
+        printf("\n");
+        failed |= !same;
+    }
+    return failed;
+}
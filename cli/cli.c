@@ -3,24 +3,51 @@
 #include "cli.h"
 
 #include "../core/core8080.h"
+#include "../core/run8080.h"
 #include "../core/disassembler.h"
+#include "../core/trace8080.h"
+#include "../core/profile8080.h"
+#include "../core/rom8080.h"
 
-int run_cli(char *filename, int debug) {
+#define RUN_BATCH 4096
+
+int run_cli(char *filename, int debug, char *trace_file, int profile) {
     struct state_8080 *state = make_state(200, 0);
-    load_bin_file(state, 0, filename);
+    if (load_rom(state, filename)) {
+        printf("Cannot Load ROM %s\n", filename);
+        free_state(state);
+        return 1;
+    }
+
+    if (trace_file) {
+        state->trace = make_trace(trace_file, TRACE_DEFAULT_RECORDS);
+        if (state->trace == NULL) printf("Cannot Create Trace %s\n", trace_file);
+    }
+    if (profile) state->profile = make_profile();
+    state->log_access = memory8080_print_access;
 
     state->sp = 150;
 
     int running = 0;
 
     while (!running) {
-        running = cpu_update(state);
-        if (debug) {
-            disassemble_8080(state->memory, state->pc);
-            print_state(state);
+        if (!debug) {
+            running = cpu_run(state, RUN_BATCH);
+            continue;
         }
+        running = cpu_update(state);
+        disassemble_8080(state->memory, state->pc);
+        print_state(state);
     }
     printf("result in a is %x\n", state->a);
-    free(state->memory);
-    free(state);
+    if (state->memory_stats.suppressed) {
+        printf("%lu illegal writes not logged\n", (unsigned long) state->memory_stats.suppressed);
+    }
+    if (state->profile) {
+        profile8080_report(stdout, state->profile, state->memory);
+        free(state->profile);
+    }
+    if (state->trace) free_trace(state->trace);
+    free_state(state);
+    return 0;
 }
\ No newline at end of file
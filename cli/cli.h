@@ -1,2 +1,2 @@
 
-int run_cli(char *target, int debug);
\ No newline at end of file
+int run_cli(char *target, int debug, char *trace_file, int profile);
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+
+#include "block8080.h"
+#include "cycles8080.h"
+
+static int instruction_length(uint8_t op) {
+    if ((op & 0xc7) == 0x06 || (op & 0xc7) == 0xc6 || op == 0xd3 || op == 0xdb) return 2;
+    if ((op & 0xcf) == 0x01 || (op & 0xc7) == 0xc2 || (op & 0xc7) == 0xc4) return 3;
+    if (op == 0x22 || op == 0x2a || op == 0x32 || op == 0x3a) return 3;
+    if (op == 0xc3 || op == 0xcb || op == 0xcd || op == 0xdd || op == 0xed || op == 0xfd) return 3;
+    return 1;
+}
+
+// jumps, calls, returns, rst, pchl and hlt, the last instruction of a block
+static int ends_block(uint8_t op) {
+    if (op == 0x76) return 1;
+    if ((op & 0xc0) != 0xc0) return 0;
+    if ((op & 0x07) == 0x00 || (op & 0x07) == 0x02 || (op & 0x07) == 0x04 || (op & 0x07) == 0x07) return 1;
+    return op == 0xc3 || op == 0xc9 || op == 0xcb || op == 0xcd || op == 0xd9 ||
+           op == 0xdd || op == 0xe9 || op == 0xed || op == 0xfd;
+}
+
+#define FUSION_PAIR(first, second, name) {first, second},
+
+static const uint8_t fusions[][2] = {
+        BLOCK_FUSIONS(FUSION_PAIR)
+};
+
+// dispatch index of the handler running op and the opcode after it together
+static int fused(uint8_t op, uint8_t next) {
+    for (int i = 0; i < (int) (sizeof(fusions) / sizeof(fusions[0])); i++) {
+        if (fusions[i][0] == op && fusions[i][1] == next) return 256 + i;
+    }
+    return op;
+}
+
+static void drop_all(struct block_cache_8080 *blocks) {
+    for (int i = 0; i < 0x10000; i++) blocks->entry[i] = NULL;
+    for (int i = 0; i < 256; i++) blocks->code[i] = 0;
+    blocks->used = 0;
+}
+
+struct block_cache_8080 *make_block_cache() {
+    return calloc(1, sizeof(struct block_cache_8080));
+}
+
+void free_block_cache(struct block_cache_8080 *blocks) {
+    free(blocks);
+}
+
+struct uop_8080 *block8080_decode(struct block_cache_8080 *blocks, const uint8_t *memory, uint16_t pc,
+                                  const void *const *dispatch) {
+    // room for the longest block and its closing micro-op, the engine holds no
+    // pointer into the cache while it decodes
+    if (blocks->used + BLOCK_MAX + 1 > BLOCK_CACHE_UOPS) drop_all(blocks);
+
+    struct uop_8080 *block = &blocks->uops[blocks->used];
+    struct uop_8080 *uop = block;
+    uint32_t at = pc;
+
+    for (int n = 0; n < BLOCK_MAX; n++) {
+        uint8_t op = memory[at];
+        int length = instruction_length(op);
+        if (at + length > 0x10000) break;
+
+        // the second of a pair has to make it into the block as well
+        int handler = op;
+        if (n + 1 < BLOCK_MAX && at + length < 0x10000 && !ends_block(op)) {
+            uint8_t next = memory[at + length];
+            if (at + length + instruction_length(next) <= 0x10000) handler = fused(op, next);
+        }
+
+        uop->handler = dispatch[handler];
+        uop->pc = at;
+        for (int i = 0; i < 3; i++) uop->bytes[i] = i < length ? memory[at + i] : 0;
+        uop->cycles = cycles_8080[op];
+        uop++;
+        at += length;
+        if (ends_block(op)) break;
+    }
+
+    if (at == pc) return NULL;
+
+    uop->handler = NULL;
+    uop->pc = BLOCK_END;
+    uop++;
+    blocks->used = uop - blocks->uops;
+
+    blocks->entry[pc] = block;
+    blocks->length[pc] = at - pc;
+    for (uint32_t page = pc >> 8; page <= (at - 1) >> 8; page++) blocks->code[page] = 1;
+    return block;
+}
+
+void block8080_drop_page(struct block_cache_8080 *blocks, uint16_t offset) {
+    int start = offset & 0xff00, end = start + 0x100;
+
+    // blocks are at most BLOCK_MAX * 3 bytes long, nothing starting further back reaches the page
+    int first = start < BLOCK_MAX * 3 ? 0 : start - BLOCK_MAX * 3;
+    for (int pc = first; pc < end; pc++) {
+        if (!blocks->entry[pc] || pc + blocks->length[pc] <= start) continue;
+        blocks->entry[pc] = NULL;
+        blocks->dropped = 1;
+    }
+    blocks->code[offset >> 8] = 0;
+}
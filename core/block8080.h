@@ -0,0 +1,75 @@
+#ifndef EMULATOR101_BLOCK8080_H
+#define EMULATOR101_BLOCK8080_H
+
+#include <stdint.h>
+
+#define BLOCK_CACHE_UOPS (1 << 16) // decoded instructions, the whole cache is dropped when it fills up
+#define BLOCK_MAX 32 // 8080 instructions per decoded block
+#define BLOCK_END 0x10000 // pc of the micro-op closing every block, never matches a real pc
+
+// opcode pairs decoded into a single micro-op: first opcode, second opcode, handler name.
+// a static list, picked by hand from the profiler's pair histogram over Space Invaders and
+// not rebuilt from profile data: each pair needs a fuse_ handler written in threaded8080.h.
+// to revisit it for another rom, run it with -p and take the hottest pairs of the report's
+// "opcode pair" table whose first opcode does not end a block. the engine's dispatch table
+// has the handlers from 256 on in this order
+#define BLOCK_FUSIONS(X) \
+    X(0x05, 0xc2, dcr_b_jnz) \
+    X(0x0d, 0xc2, dcr_c_jnz) \
+    X(0x15, 0xc2, dcr_d_jnz) \
+    X(0x1d, 0xc2, dcr_e_jnz) \
+    X(0x3d, 0xc2, dcr_a_jnz) \
+    X(0xfe, 0xca, cpi_jz) \
+    X(0xfe, 0xc2, cpi_jnz) \
+    X(0xfe, 0xda, cpi_jc) \
+    X(0xfe, 0xd2, cpi_jnc) \
+    X(0xa7, 0xca, ana_a_jz) \
+    X(0xa7, 0xc2, ana_a_jnz) \
+    X(0xb7, 0xca, ora_a_jz) \
+    X(0xb7, 0xc2, ora_a_jnz) \
+    X(0x3a, 0xa7, lda_ana_a) \
+    X(0x7e, 0x23, mov_a_m_inx_h) \
+    X(0x77, 0x23, mov_m_a_inx_h) \
+    X(0x36, 0x23, mvi_m_inx_h) \
+    X(0x1a, 0x77, ldax_d_mov_m_a) \
+    X(0x7d, 0xe6, mov_a_l_ani) \
+    X(0x7c, 0xfe, mov_a_h_cpi)
+
+// one decoded instruction. handler is the threaded engine's label for the opcode and
+// bytes a copy of the instruction, so running it never touches state->memory. the first
+// instruction of a fused pair gets the pair's handler, which goes on to the second micro-op
+// itself
+struct uop_8080 {
+    const void *handler;
+    uint32_t pc;
+    uint8_t bytes[3];
+    uint8_t cycles;
+};
+
+struct block_cache_8080 {
+    struct uop_8080 *entry[0x10000]; // first micro-op of the block decoded at each pc, NULL if none
+    uint8_t length[0x10000]; // bytes of memory the block at each pc was decoded from
+    uint8_t code[256]; // pages some block was decoded from
+    int dropped; // set when a write dropped blocks, the engine then looks its pc up again
+    uint32_t used;
+    struct uop_8080 uops[BLOCK_CACHE_UOPS];
+};
+
+struct block_cache_8080 *make_block_cache();
+
+void free_block_cache(struct block_cache_8080 *blocks);
+
+// decodes the block starting at pc, handlers come from the engine's dispatch table.
+// returns NULL when the instruction at pc runs past the top of memory
+struct uop_8080 *block8080_decode(struct block_cache_8080 *blocks, const uint8_t *memory, uint16_t pc,
+                                  const void *const *dispatch);
+
+// drops every block decoded from the page holding offset
+void block8080_drop_page(struct block_cache_8080 *blocks, uint16_t offset);
+
+// memory8080_write calls it for each byte it changes
+static inline void block8080_invalidate(struct block_cache_8080 *blocks, uint16_t offset) {
+    if (blocks->code[offset >> 8]) block8080_drop_page(blocks, offset);
+}
+
+#endif //EMULATOR101_BLOCK8080_H
@@ -12,4 +12,11 @@
 #define SCREEN_HEIGHT 256
 
 #define FPS 60
-#define VRAM_ADDRESS 0x2400
\ No newline at end of file
+#define CPU_CLOCK_HZ 2000000
+#define CYCLES_PER_FRAME (CPU_CLOCK_HZ / FPS)
+#define VRAM_ADDRESS 0x2400
+#define VRAM_SIZE 0x1c00
+#define ROM_SIZE 0x2000
+#define RAM_ADDRESS 0x2000
+#define RAM_SIZE 0x2000
+#define RAM_MIRROR_ADDRESS 0x4000
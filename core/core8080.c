@@ -1,56 +1,16 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "core8080.h"
 #include "io8080.h"
 #include "util.h"
+#include "cycles8080.h"
 #include "disassembler.h"
-
-// cpu instruction abstractions
-void core8080_add(struct state_8080 *state, uint8_t value);
-
-void core808_adc(struct state_8080 *state, uint8_t value);
-
-void core8080_sub(struct state_8080 *state, uint8_t value);
-
-void core8080_sbb(struct state_8080 *state, uint8_t value);
-
-void core8080_call(struct state_8080 *state, uint16_t addr);
-
-void core8080_ret(struct state_8080 *state);
-
-void core8080_push(struct state_8080 *state, uint8_t hb, uint8_t lb);
-
-uint16_t core8080_pop(struct state_8080 *state);
-
-void core8080_jump(struct state_8080 *state, uint16_t addr);
-
-void core8080_cmp(struct state_8080 *state, uint8_t value);
-
-void core8080_and(struct state_8080 *state, uint8_t value);
-
-void core8080_or(struct state_8080 *state, uint8_t value);
-
-void core8080_xor(struct state_8080 *state, uint8_t value);
-
-void core8080_write_byte(struct state_8080 *state, uint16_t offset, uint8_t value);
-
-uint8_t core8080_read_byte(struct state_8080 *state, uint16_t offset);
-
-void core8080_io_read(struct state_8080 *state, int port);
-void core8080_io_write(struct state_8080 *state, int port);
-
-// util functions
-
-uint8_t pack_flags(struct state_8080 *state);
-
-void unpack_flags(struct state_8080 *state, uint8_t psw);
-void print_state(struct state_8080 *state);
-
-void update_flags(struct state_8080 *state, uint16_t value);
-
-int parity(int x, int size);
+#include "trace8080.h"
+#include "rom8080.h"
+#include "recomp8080.h"
 
 int cpu_update(struct state_8080 *state) {
     unsigned char *opcode = &state->memory[state->pc];
@@ -58,12 +18,22 @@ int cpu_update(struct state_8080 *state) {
     uint8_t value, b1, b2;
     int addr;
 
+    if (state->trace) trace8080_record(state->trace, state);
+    state->cycles += cycles_8080[*opcode];
+
     switch (*opcode) {
         case 0x00: //NOP
+        case 0x08: // undocumented NOPs
+        case 0x10:
+        case 0x18:
+        case 0x20:
+        case 0x28:
+        case 0x30:
+        case 0x38:
             break;
         case 0x01: // LXI B, D16
-            b1 = core8080_read_byte(state, opcode[1]);
-            b2 = core8080_read_byte(state, opcode[2]);
+            b1 = opcode[1];
+            b2 = opcode[2];
             state->b = b2;
             state->c = b1;
             state->pc += 2;
@@ -77,15 +47,14 @@ int cpu_update(struct state_8080 *state) {
             w += 1;
             state->b = get_high_byte(w);
             state->c = get_low_byte(w);
-            update_flags(state, w);
             break;
         case 0x04: // INC B
             state->b += 1;
-            update_flags(state, state->b);
+            FLAGS_INR(state, state->b);
             break;
         case 0x05: // DCR B
             state->b -= 1;
-            update_flags(state, state->b);
+            FLAGS_DCR(state, state->b);
             break;
         case 0x06: // MVI B, D8
             b1 = opcode[1];
@@ -95,107 +64,158 @@ int cpu_update(struct state_8080 *state) {
         case 0x07: // RLC
             b1 = (state->a & 0x80) != 0;
             state->a = state->a << 1 | b1;
-            state->flags.cy = b1;
+            FLAGS(state).cy = b1;
+            break;
+        case 0x09: // DAD B
+            core8080_dad(state, make_word(state->b, state->c));
+            break;
+        case 0x0a: // LDAX B
+            offset = make_word(state->b, state->c);
+            state->a = core8080_read_byte(state, offset);
             break;
         case 0x0b: // DCX B
             w = make_word(state->b, state->c);
             w -= 1;
             state->b = get_high_byte(w);
             state->c = get_low_byte(w);
-            update_flags(state, w);
             break;
         case 0x0c: // INR C
             state->c += 1;
-            update_flags(state, state->c);
+            FLAGS_INR(state, state->c);
             break;
         case 0x0d: // DCR C
             state->c -= 1;
-            update_flags(state, state->c);
+            FLAGS_DCR(state, state->c);
             break;
         case 0x0f: // RRC
             b1 = (state->a & 0x1);
-            state->a = (state->a >> 1) | (0b1 << b1);
-            state->flags.cy = b1;
+            state->a = (state->a >> 1) | (b1 << 7);
+            FLAGS(state).cy = b1;
             break;
         case 0x0e: // MVI C, D8
             b1 = opcode[1];
             state->c = b1;
             state->pc += 1;
             break;
+        case 0x11: // LXI D, D16
+            state->d = opcode[2];
+            state->e = opcode[1];
+            state->pc += 2;
+            break;
+        case 0x12: // STAX D
+            offset = make_word(state->d, state->e);
+            core8080_write_byte(state, offset, state->a);
+            break;
         case 0x13: // INX D
             w = make_word(state->d, state->e);
             w += 1;
             state->d = get_high_byte(w);
             state->e = get_low_byte(w);
-            update_flags(state, w);
             break;
         case 0x14: // INR D
             state->d += 1;
-            update_flags(state, state->d);
+            FLAGS_INR(state, state->d);
             break;
         case 0x15: // DCR D
             state->d -= 1;
-            update_flags(state, state->d);
+            FLAGS_DCR(state, state->d);
             break;
         case 0x16: // MVI D, D8
             b1 = opcode[1];
             state->d = b1;
             state->pc += 1;
             break;
+        case 0x17: // RAL
+            b1 = (state->a & 0x80) != 0;
+            state->a = state->a << 1 | FLAGS_READ(state).cy;
+            FLAGS(state).cy = b1;
+            break;
+        case 0x19: // DAD D
+            core8080_dad(state, make_word(state->d, state->e));
+            break;
+        case 0x1a: // LDAX D
+            offset = make_word(state->d, state->e);
+            state->a = core8080_read_byte(state, offset);
+            break;
         case 0x1b: // DCX D
             w = make_word(state->d, state->e);
             w -= 1;
             state->d = get_high_byte(w);
             state->e = get_low_byte(w);
-            update_flags(state, w);
             break;
         case 0x1c: // INR E
             state->e += 1;
-            update_flags(state, state->e);
+            FLAGS_INR(state, state->e);
             break;
         case 0x1d: // DCR E
             state->e -= 1;
-            update_flags(state, state->e);
+            FLAGS_DCR(state, state->e);
             break;
         case 0x1e: // MVI E, D8
             b1 = opcode[1];
             state->e = b1;
             state->pc += 1;
             break;
+        case 0x1f: // RAR
+            b1 = state->a & 0x1;
+            state->a = (state->a >> 1) | (FLAGS_READ(state).cy << 7);
+            FLAGS(state).cy = b1;
+            break;
+        case 0x21: // LXI H, D16
+            state->h = opcode[2];
+            state->l = opcode[1];
+            state->pc += 2;
+            break;
+        case 0x22: // SHLD adr
+            offset = make_word(opcode[2], opcode[1]);
+            core8080_write_byte(state, offset, state->l);
+            core8080_write_byte(state, offset + 1, state->h);
+            state->pc += 2;
+            break;
         case 0x23: // INX H
             w = make_word(state->h, state->l);
             w += 1;
             state->h = get_high_byte(w);
             state->l = get_low_byte(w);
-            update_flags(state, w);
             break;
         case 0x24: // INR H
             state->h += 1;
-            update_flags(state, state->h);
+            FLAGS_INR(state, state->h);
             break;
         case 0x25: // DCR H
             state->h -= 1;
-            update_flags(state, state->h);
+            FLAGS_DCR(state, state->h);
             break;
         case 0x26: // MVI H, D8
             b1 = opcode[1];
             state->h = b1;
             state->pc += 1;
             break;
+        case 0x27: // DAA
+            core8080_daa(state);
+            break;
+        case 0x29: // DAD H
+            core8080_dad(state, make_word(state->h, state->l));
+            break;
+        case 0x2a: // LHLD adr
+            offset = make_word(opcode[2], opcode[1]);
+            state->l = core8080_read_byte(state, offset);
+            state->h = core8080_read_byte(state, offset + 1);
+            state->pc += 2;
+            break;
         case 0x2b: // DCX H
             w = make_word(state->h, state->l);
             w -= 1;
             state->h = get_high_byte(w);
             state->l = get_low_byte(w);
-            update_flags(state, w);
             break;
         case 0x2c: // INR L
             state->l += 1;
-            update_flags(state, state->l);
+            FLAGS_INR(state, state->l);
             break;
         case 0x2d: // DCR L
             state->l -= 1;
-            update_flags(state, state->l);
+            FLAGS_DCR(state, state->l);
             break;
 
         case 0x2e: // MVI L, D8
@@ -206,9 +226,14 @@ int cpu_update(struct state_8080 *state) {
         case 0x2f: // CMA
             state->a = ~state->a;
             break;
+        case 0x31: // LXI SP, D16
+            state->sp = make_word(opcode[2], opcode[1]);
+            state->pc += 2;
+            break;
         case 0x32: // STA adr
-            offset = make_word(opcode[1], opcode[2]);
+            offset = make_word(opcode[2], opcode[1]);
             core8080_write_byte(state, offset, state->a);
+            state->pc += 2;
             break;
         case 0x33: // INX SP
             state->sp += 1;
@@ -217,35 +242,40 @@ int cpu_update(struct state_8080 *state) {
             offset = make_word(state->h, state->l);
             b1 = core8080_read_byte(state, offset) + 1;
             core8080_write_byte(state, offset, b1);
-            update_flags(state, b1);
+            FLAGS_INR(state, b1);
             break;
         case 0x35: // DCR M
             offset = make_word(state->h, state->l);
             b1 = core8080_read_byte(state, offset) - 1;
             core8080_write_byte(state, offset, b1);
-            update_flags(state, b1);
+            FLAGS_DCR(state, b1);
             break;
         case 0x3b: // DCX SP
             state->sp -= 1;
             break;
         case 0x3c: // INR A
             state->a += 1;
-            update_flags(state, state->a);
+            FLAGS_INR(state, state->a);
             break;
         case 0x3d: // DCR A
             state->a -= 1;
-            update_flags(state, state->a);
+            FLAGS_DCR(state, state->a);
             break;
         case 0x36: // MVI M, D8
             offset = make_word(state->h, state->l);
             core8080_write_byte(state, offset, opcode[1]);
+            state->pc += 1;
+            break;
+        case 0x37: // STC
+            FLAGS(state).cy = 1;
             break;
-        case 0x39: // STC
-            state->flags.cy = 1;
+        case 0x39: // DAD SP
+            core8080_dad(state, state->sp);
             break;
-        case 0x3a: // LDA D8
-            offset = make_word(opcode[1], opcode[2]);
+        case 0x3a: // LDA adr
+            offset = make_word(opcode[2], opcode[1]);
             state->a = core8080_read_byte(state, offset);
+            state->pc += 2;
             break;
         case 0x3e: // MVI, A, D8
             b1 = opcode[1];
@@ -253,7 +283,7 @@ int cpu_update(struct state_8080 *state) {
             state->pc += 1;
             break;
         case 0x3f: // CMC
-            state->flags.cy = ~state->flags.cy;
+            FLAGS(state).cy = !FLAGS(state).cy;
             break;
         case 0x40: // MOV B, B
             break;
@@ -422,9 +452,10 @@ int cpu_update(struct state_8080 *state) {
             break;
         case 0x75: // MOV M, L
             offset = make_word(state->h, state->l);
-            core8080_write_byte(state, offset, state->c);
+            core8080_write_byte(state, offset, state->l);
             break;
         case 0x76: // HLT
+            state->halted = 1;
             return 1;
             break;
         case 0x77: // MOV M, A
@@ -446,7 +477,8 @@ int cpu_update(struct state_8080 *state) {
         case 0x7C: // MOV A, H
             state->a = state->h;
             break;
-        case 0x7D: // MOV A, A
+        case 0x7D: // MOV A, L
+            state->a = state->l;
             break;
         case 0x7E: // MOV A, M == MOV A, [hl]
             offset = make_word(state->h, state->l);
@@ -630,22 +662,55 @@ int cpu_update(struct state_8080 *state) {
         case 0xb7: // ORA A
             core8080_or(state, state->a);
             break;
+        case 0xb8: // CMP B
+            core8080_cmp(state, state->b);
+            break;
+        case 0xb9: // CMP C
+            core8080_cmp(state, state->c);
+            break;
+        case 0xba: // CMP D
+            core8080_cmp(state, state->d);
+            break;
+        case 0xbb: // CMP E
+            core8080_cmp(state, state->e);
+            break;
+        case 0xbc: // CMP H
+            core8080_cmp(state, state->h);
+            break;
+        case 0xbd: // CMP L
+            core8080_cmp(state, state->l);
+            break;
+        case 0xbe: // CMP M
+            core8080_cmp(state, core8080_read_byte(state, make_word(state->h, state->l)));
+            break;
+        case 0xbf: // CMP A
+            core8080_cmp(state, state->a);
+            break;
+        case 0xc0: // rnz
+            if (!FLAGS_READ(state).z) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_ret(state);
+                return 0;
+            }
+            break;
         case 0xc1: // POP B
             w = core8080_pop(state);
             state->b = get_high_byte(w);
             state->c = get_low_byte(w);
             break;
         case 0xc2: // jnz adr
-            if (!state->flags.z) {
+            if (!FLAGS_READ(state).z) {
                 core8080_jump(state, make_word(opcode[2], opcode[1]));
                 return 0;
             } else state->pc += 2;
             break;
         case 0xc3: // jmp adr
+        case 0xcb: // undocumented jmp
             core8080_jump(state, make_word(opcode[2], opcode[1]));
             return 0;
         case 0xc4: // cnz adr
-            if (!state->flags.z) {
+            if (!FLAGS_READ(state).z) {
+                state->cycles += CYCLES_8080_TAKEN;
                 core8080_call(state, make_word(opcode[2], opcode[1]));
                 return 0;
             } else state->pc += 2;
@@ -657,43 +722,84 @@ int cpu_update(struct state_8080 *state) {
         case 0xc6: // ADI D8
             b1 = opcode[1];
             core8080_add(state, b1);
+            state->pc += 1;
             break;
         case 0xc8: // rz
-            if (state->flags.z) {
+            if (FLAGS_READ(state).z) {
+                state->cycles += CYCLES_8080_TAKEN;
                 core8080_ret(state);
                 return 0;
             }
             break;
         case 0xc9: // ret
+        case 0xd9: // undocumented ret
             core8080_ret(state);
             return 0;
         case 0xca: // jz adr
-            if (state->flags.z) {
+            if (FLAGS_READ(state).z) {
                 core8080_jump(state, make_word(opcode[2], opcode[1]));
                 return 0;
             } else state->pc += 2;
             break;
+        case 0xcc: // cz adr
+            if (FLAGS_READ(state).z) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_call(state, make_word(opcode[2], opcode[1]));
+                return 0;
+            } else state->pc += 2;
+            break;
+        case 0xce: // ACI D8
+            b1 = opcode[1];
+            core808_adc(state, b1);
+            state->pc += 1;
+            break;
+        case 0xd0: // rnc
+            if (!FLAGS_READ(state).cy) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_ret(state);
+                return 0;
+            }
+            break;
         case 0xd1: // POP D
             w = core8080_pop(state);
             state->d = get_high_byte(w);
             state->e = get_low_byte(w);
             break;
         case 0xd2: // jnc adr
-            if (state->flags.cy) {
+            if (!FLAGS_READ(state).cy) {
                 core8080_jump(state, make_word(opcode[2], opcode[1]));
                 return 0;
-            }
+            } else state->pc += 2;
             break;
         case 0xd3: // OUT D8
             b1 = opcode[1];
             core8080_io_write(state, b1);
             state->pc += 1;
             break;
+        case 0xd4: // cnc adr
+            if (!FLAGS_READ(state).cy) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_call(state, make_word(opcode[2], opcode[1]));
+                return 0;
+            } else state->pc += 2;
+            break;
         case 0xd5: // PUSH D
             core8080_push(state, state->d, state->e);
             break;
+        case 0xd6: // SUI D8
+            b1 = opcode[1];
+            core8080_sub(state, b1);
+            state->pc += 1;
+            break;
+        case 0xd8: // rc
+            if (FLAGS_READ(state).cy) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_ret(state);
+                return 0;
+            }
+            break;
         case 0xda: // jc adr
-            if (!state->flags.cy) {
+            if (FLAGS_READ(state).cy) {
                 core8080_jump(state, make_word(opcode[2], opcode[1]));
                 return 0;
             } else state->pc += 2;
@@ -703,39 +809,79 @@ int cpu_update(struct state_8080 *state) {
             core8080_io_read(state, b1);
             state->pc += 1;
             break;
-        case 0xdc: //
-            if (!state->flags.cy) {
+        case 0xdc: // cc adr
+            if (FLAGS_READ(state).cy) {
+                state->cycles += CYCLES_8080_TAKEN;
                 core8080_call(state, make_word(opcode[2], opcode[1]));
                 return 0;
-            }
+            } else state->pc += 2;
             break;
         case 0xcd: // call adr
+        case 0xdd: // undocumented calls
+        case 0xed:
+        case 0xfd:
             core8080_call(state, make_word(opcode[2], opcode[1]));
             return 0;
+        case 0xde: // SBI D8
+            b1 = opcode[1];
+            core8080_sbb(state, b1);
+            state->pc += 1;
+            break;
+        case 0xe0: // rpo
+            if (!FLAGS_READ(state).p) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_ret(state);
+                return 0;
+            }
+            break;
         case 0xe1: // POP H
             w = core8080_pop(state);
             state->h = get_high_byte(w);
             state->l = get_low_byte(w);
             break;
         case 0xe2: // jpo
-            if (state->flags.p) {
+            if (!FLAGS_READ(state).p) {
                 core8080_jump(state, make_word(opcode[2], opcode[1]));
                 return 0;
             } else state->pc += 2;
             break;
         case 0xe3: // XTHL
             w = core8080_pop(state);
+            core8080_push(state, state->h, state->l);
             state->h = get_high_byte(w);
             state->l = get_low_byte(w);
             break;
+        case 0xe4: // cpo adr
+            if (!FLAGS_READ(state).p) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_call(state, make_word(opcode[2], opcode[1]));
+                return 0;
+            } else state->pc += 2;
+            break;
         case 0xe5: // PUSH H
             core8080_push(state, state->h, state->l);
             break;
         case 0xe6: // ANI D8
             b1 = opcode[1];
-            state->a = state->a & b1;
+            core8080_and(state, b1);
             state->pc += 1;
             break;
+        case 0xe8: // rpe
+            if (FLAGS_READ(state).p) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_ret(state);
+                return 0;
+            }
+            break;
+        case 0xe9: // PCHL
+            state->pc = make_word(state->h, state->l);
+            return 0;
+        case 0xea: // jpe adr
+            if (FLAGS_READ(state).p) {
+                core8080_jump(state, make_word(opcode[2], opcode[1]));
+                return 0;
+            } else state->pc += 2;
+            break;
         case 0xeb: // XCHG
             b1 = state->h;
             b2 = state->l;
@@ -744,22 +890,97 @@ int cpu_update(struct state_8080 *state) {
             state->d = b1;
             state->e = b2;
             break;
+        case 0xec: // cpe adr
+            if (FLAGS_READ(state).p) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_call(state, make_word(opcode[2], opcode[1]));
+                return 0;
+            } else state->pc += 2;
+            break;
+        case 0xee: // XRI D8
+            b1 = opcode[1];
+            core8080_xor(state, b1);
+            state->pc += 1;
+            break;
+        case 0xf0: // rp
+            if (!FLAGS_READ(state).s) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_ret(state);
+                return 0;
+            }
+            break;
         case 0xf1: // POP PSW
             w = core8080_pop(state);
             state->a = get_high_byte(w);
             unpack_flags(state, get_low_byte(w));
             break;
+        case 0xf2: // jp adr
+            if (!FLAGS_READ(state).s) {
+                core8080_jump(state, make_word(opcode[2], opcode[1]));
+                return 0;
+            } else state->pc += 2;
+            break;
+        case 0xf4: // cp adr
+            if (!FLAGS_READ(state).s) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_call(state, make_word(opcode[2], opcode[1]));
+                return 0;
+            } else state->pc += 2;
+            break;
         case 0xf5: // PUSH PSW
             core8080_push(state, state->a, pack_flags(state));
             break;
+        case 0xf3: // DI
+            state->int_enable = 0;
+            break;
+        case 0xf6: // ORI D8
+            b1 = opcode[1];
+            core8080_or(state, b1);
+            state->pc += 1;
+            break;
+        case 0xf8: // rm
+            if (FLAGS_READ(state).s) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_ret(state);
+                return 0;
+            }
+            break;
         case 0xf9: // SPHL
             state->sp = make_word(state->h, state->l);
             break;
+        case 0xfa: // jm adr
+            if (FLAGS_READ(state).s) {
+                core8080_jump(state, make_word(opcode[2], opcode[1]));
+                return 0;
+            } else state->pc += 2;
+            break;
+        case 0xfb: // EI
+            state->int_enable = 1;
+            break;
+        case 0xfc: // cm adr
+            if (FLAGS_READ(state).s) {
+                state->cycles += CYCLES_8080_TAKEN;
+                core8080_call(state, make_word(opcode[2], opcode[1]));
+                return 0;
+            } else state->pc += 2;
+            break;
         case 0xfe: // CPI
             b1 = opcode[1];
             core8080_cmp(state, b1);
             state->pc += 1;
             break;
+        case 0xc7: // RST 0
+        case 0xcf: // RST 1
+        case 0xd7: // RST 2
+        case 0xdf: // RST 3
+        case 0xe7: // RST 4
+        case 0xef: // RST 5
+        case 0xf7: // RST 6
+        case 0xff: // RST 7
+            offset = state->pc + 1;
+            state->pc = *opcode & 0x38;
+            core8080_push(state, get_high_byte(offset), get_low_byte(offset));
+            return 0;
         default:
             printf("Panic! Unknown Instruction %x", opcode[0]);
             exit(1);
@@ -768,99 +989,54 @@ int cpu_update(struct state_8080 *state) {
     return 0;
 }
 
-int gpu_update(struct state_8080 *state) {
-
-	    for (int i = 0; i < 256 * 224 / 8; i++) {
-        const int y = i * 8 / 256;
-        const int base_x = (i * 8) % 256;
-        const uint8_t cur_byte = state->memory[VRAM_ADDRESS + i];
-
-        for (uint8_t bit = 0; bit < 8; bit++) {
-            int px = base_x + bit;
-            int py = y;
-            const uint8_t is_pixel_lit = (cur_byte >> bit) & 1;
-            uint8_t r = 0, g = 0, b = 0;
-
-
-            if (is_pixel_lit) {
-                if (px < 16) {
-                    if (py < 16 || py > 118 + 16) {
-                        r = 255; g = 255; b = 255;
-                    }
-                    else {
-                        g = 255;
-                    }
-                }
-                else if (px >= 16 && px <= 16 + 56) {
-                    g = 255;
-                }
-                else if (px >= 16 + 56 + 120 && px < 16 + 56 + 120 + 32) {
-                    r = 255;
-                }
-                else {
-                    r = 255; g = 255; b = 255;
-                }
-            }
-
-            // space invaders' screen is rotated 90 degrees anti-clockwise
-            // so we invert the coordinates:
-            const int temp_x = px;
-            px = py;
-            py = -temp_x + SCREEN_HEIGHT - 1;
+int cpu_interrupt(struct state_8080 *state, int rst) {
+    if (!state->int_enable) return 0;
 
-            state->screen_buffer[py][px][0] = r;
-            state->screen_buffer[py][px][1] = g;
-            state->screen_buffer[py][px][2] = b;
-        }
-    }
+    // an interrupt wakes a halted cpu, it returns past the HLT. one that merely stopped on
+    // a HLT it has not run yet returns to it
+    uint16_t offset = state->pc;
+    if (state->halted) offset += 1;
+    state->halted = 0;
 
-    state->update_screen(state);
-	return 0;
+    core8080_push(state, get_high_byte(offset), get_low_byte(offset));
+    state->pc = rst * 8;
+    state->int_enable = 0;
+    state->cycles += cycles_8080[0xc7];
+    return 1;
 }
 
 void core8080_add(struct state_8080 *state, uint8_t value) {
   uint16_t sum = (uint16_t) state->a + (uint16_t) value;
-	update_flags(state, sum);
+  FLAGS_ADD(state, state->a, value, sum);
   state->a = sum & 0xff;
 }
 
 void core808_adc(struct state_8080 *state, uint8_t value) {
-  uint16_t sum = (uint16_t) state->a + (uint16_t) value + (uint16_t) state->flags.cy;
-	update_flags(state, sum);
+  uint16_t sum = (uint16_t) state->a + (uint16_t) value + (uint16_t) FLAGS_READ(state).cy;
+  FLAGS_ADD(state, state->a, value, sum);
   state->a = sum & 0xff;
 }
 
 void core8080_sub(struct state_8080 *state, uint8_t value) {
   uint16_t diff = (uint16_t) state->a - (uint16_t) value;
-	update_flags(state, diff);
+  FLAGS_SUB(state, state->a, value, diff);
   state->a = diff & 0xff;
 }
 
 void core8080_sbb(struct state_8080 *state, uint8_t value) {
-  uint16_t diff = (uint16_t) state->a - (uint16_t) value - (uint16_t) state->flags.cy;
-	update_flags(state, diff);	
+  uint16_t diff = (uint16_t) state->a - (uint16_t) value - (uint16_t) FLAGS_READ(state).cy;
+  FLAGS_SUB(state, state->a, value, diff);
   state->a = diff & 0xff;
 }
 
-void update_flags(struct state_8080 *state, uint16_t value) {
-	state->flags.z = ((value & 0xff) == 0);
-	state->flags.s = ((value & 0x80) != 0);
-	state->flags.cy = (value > 0xff);
-	state->flags.p = parity(value & 0xff, 8);
-}
-
 void core8080_call(struct state_8080 *state, uint16_t addr) {
-  uint16_t offset = state->pc + 2;
-  state->memory[state->sp - 1] = (offset >> 8) & 0xff;
-  state->memory[state->sp - 2] = offset & 0xff;
-  state->sp = state->sp - 2;
+  uint16_t offset = state->pc + 3;
+  core8080_push(state, get_high_byte(offset), get_low_byte(offset));
   state->pc = addr;
 }
 
 void core8080_ret(struct state_8080 *state) {
-  uint16_t offset = state->sp;
-  state->pc = make_word(state->memory[offset], state->memory[offset + 1]);
-  state->sp += 2;
+  state->pc = core8080_pop(state);
 }
 
 void core8080_jump(struct state_8080 *state, uint16_t addr) {
@@ -868,26 +1044,47 @@ void core8080_jump(struct state_8080 *state, uint16_t addr) {
 }
 
 void core8080_cmp(struct state_8080 *state, uint8_t value) {
-	uint16_t diff = state->a - value;
-	update_flags(state, diff);
+	uint16_t diff = (uint16_t) state->a - (uint16_t) value;
+	FLAGS_SUB(state, state->a, value, diff);
 }
 
 void core8080_and(struct state_8080 *state, uint8_t value) {
-	uint16_t and = state->a & value;
+	uint8_t and = state->a & value;
+	FLAGS_AND(state, state->a, value, and);
 	state->a = and;
-	update_flags(state, and);
 }
 
 void core8080_or(struct state_8080 *state, uint8_t value) {
-	uint16_t or = state->a | value;
+	uint8_t or = state->a | value;
 	state->a = or;
-	update_flags(state, or);
+	FLAGS_LOGIC(state, or);
 }
 
 void core8080_xor(struct state_8080 *state, uint8_t value) {
-	uint16_t xor = state->a ^ value;
+	uint8_t xor = state->a ^ value;
 	state->a = xor;
-	update_flags(state, xor);
+	FLAGS_LOGIC(state, xor);
+}
+
+void core8080_dad(struct state_8080 *state, uint16_t value) {
+	uint32_t sum = (uint32_t) make_word(state->h, state->l) + value;
+	FLAGS(state).cy = sum > 0xffff;
+	state->h = get_high_byte(sum);
+	state->l = get_low_byte(sum);
+}
+
+// adjusts a to two bcd digits after an add. the high digit carry is sticky so it is folded
+// into bit 8 of the sum before the flags see it
+void core8080_daa(struct state_8080 *state) {
+	uint8_t a = state->a, cy = FLAGS_READ(state).cy, correction = 0;
+	if ((a & 0xf) > 9 || FLAGS(state).ac) correction |= 0x06;
+	if (a > 0x99 || cy) {
+		correction |= 0x60;
+		cy = 1;
+	}
+	uint16_t sum = ((uint16_t) a + correction) | (uint16_t) cy << 8;
+	FLAGS_ADD(state, a, correction, sum);
+	state->a = sum & 0xff;
 }
 
 void core8080_push(struct state_8080 *state, uint8_t hb, uint8_t lb) {
@@ -906,64 +1103,106 @@ uint16_t core8080_pop(struct state_8080 *state) {
 	return make_word(b1, b2);
 }
 
-void core8080_write_byte(struct state_8080 *state, uint16_t offset, uint8_t value) {
-	if (state->ram_offset <= offset) state->memory[offset] = value;
-	else printf("Cannot Write To Offset %x, Part Of ROM\n", offset); 
-}
-
-uint8_t core8080_read_byte(struct state_8080 *state, uint16_t offset) {
-	if (state->ram_offset <= offset) return state->memory[offset];
-	return 0;
-}
-
 
 void print_state(struct state_8080 *state) {
+	struct flags_8080 *flags = &FLAGS(state);
 	printf("A: %x, B: %x, C: %x, D: %x, E: %x, H: %x, L: %x \n", state->a, state->b, state->c, state->d, state->e, state->h, state->l);
-	printf("Z: %x, S: %x, CY: %x, AC: %x, P: %x \n\n", state->flags.z, state->flags.s, state->flags.cy, state->flags.ac, state->flags.p);
+	printf("Z: %x, S: %x, CY: %x, AC: %x, P: %x \n\n", flags->z, flags->s, flags->cy, flags->ac, flags->p);
 }
 
 uint8_t pack_flags(struct state_8080 *state) {
-	return (state->flags.z | state->flags.s << 1 | state->flags.p << 2 | state->flags.cy << 3 | state->flags.ac << 4);  
+	struct flags_8080 *flags = &FLAGS(state);
+	return (flags->z | flags->s << 1 | flags->p << 2 | flags->cy << 3 | flags->ac << 4);
 }
 
 void unpack_flags(struct state_8080 *state, uint8_t psw) {
-	state->flags.z = 0x01 == (psw & 0x01);
-	state->flags.s = 0x02 == (psw & 0x02);
-	state->flags.p = 0x04 == (psw & 0x04);
-	state->flags.cy = 0x08 == (psw & 0x08);
-	state->flags.ac = 0x10 == (psw & 0x10);
+	struct flags_8080 *flags = &FLAGS(state);
+	flags->z = 0x01 == (psw & 0x01);
+	flags->s = 0x02 == (psw & 0x02);
+	flags->p = 0x04 == (psw & 0x04);
+	flags->cy = 0x08 == (psw & 0x08);
+	flags->ac = 0x10 == (psw & 0x10);
 }
 
+// a state without io, the cli's, reads zeros and goes nowhere
 void core8080_io_read(struct state_8080 *state, int port) {
-	state->a = io8080_read_port(state->io, port);
-	state->io->notify_read(port);
+	state->a = state->io ? io8080_in(state->io, port) : 0;
 }
 
 void core8080_io_write(struct state_8080 *state, int port) {
-	io8080_write_port(state->io, port, state->a);
-	state->io->notify_write(port);
+	if (state->io) io8080_out(state->io, port, state->a);
 }
 
 int load_bin_file(struct state_8080 *state, int offset, char *file_name) {
-	FILE *fd = fopen(file_name, "rb");
-
-	fseek(fd, 0L, SEEK_END);
-	int fsize = ftell(fd);
-	fseek(fd, 0L, SEEK_SET);
-	printf("fsize %d\n", fsize);
-	uint8_t *mem = malloc(fsize);
-	fread(mem, fsize, 1, fd);
-	fclose(fd);
-	for (int i = 0; i < fsize; i++) {
-        core8080_write_byte(state, offset + i, mem[i]);
-	}
+	struct rom_8080 *rom = open_rom_file(file_name, offset);
 
-	return 0;
+	if (rom == NULL) return -1;
+	int result = rom8080_load(rom, state);
+	close_rom(rom);
+	return result;
 }
 
 struct state_8080 *make_state(int mem_size, uint16_t ram_offset) {
-	struct state_8080 *state = malloc(sizeof(struct state_8080));
-	state->memory = calloc(mem_size, sizeof(uint8_t));
+	struct state_8080 *state = calloc(1, sizeof(struct state_8080));
+
+	// all 64K whatever mem_size is, so nothing indexing memory with a 16 bit offset goes past it,
+	// and a page of zeros for the operands of an instruction at 0xffff
+	if (memory8080_allocate(state)) {
+		free(state);
+		return NULL;
+	}
+	state->memory_size = mem_size < MEMORY_HOST_SIZE ? mem_size : MEMORY_HOST_SIZE;
 	state->ram_offset = ram_offset;
+	memory8080_init(state, state->memory_size, ram_offset);
+	// the first frame has to draw everything
+	memset(state->vram_dirty, 0xff, sizeof(state->vram_dirty));
 	return state;
 }
+
+struct state_8080 *state_fork(struct state_8080 *parent) {
+	struct state_8080 *child = malloc(sizeof(struct state_8080));
+	struct recomp_8080 *recomp = parent->recomp ? malloc(sizeof(struct recomp_8080)) : NULL;
+
+	if (child == NULL || (parent->recomp && recomp == NULL)) {
+		free(child);
+		free(recomp);
+		return NULL;
+	}
+
+	// registers, flags, cycles, the memory map and its counters
+	*child = *parent;
+	if (memory8080_fork(parent, child)) {
+		free(child);
+		free(recomp);
+		return NULL;
+	}
+
+	// ports keep their latched bytes, devices hold state of their own and are the caller's
+	child->io = NULL;
+	if (parent->io) {
+		child->io = make_io(IO_PORTS);
+		if (child->io == NULL) {
+			memory8080_release(child);
+			free(child);
+			free(recomp);
+			return NULL;
+		}
+		memcpy(child->io->ports, parent->io->ports, IO_PORTS);
+	}
+	// the translation is shared, which of its pages were written is not
+	if (recomp) *recomp = *parent->recomp;
+	child->recomp = recomp;
+	child->frames = NULL;
+	child->trace = NULL;
+	child->profile = NULL;
+	child->jit = NULL;
+	child->blocks = NULL;
+	child->update_screen = NULL;
+	memset(child->vram_dirty, 0xff, sizeof(child->vram_dirty));
+	return child;
+}
+
+void free_state(struct state_8080 *state) {
+	memory8080_release(state);
+	free(state);
+}
@@ -3,18 +3,16 @@
 #include <stddef.h>
 
 #include "constants.h"
+#include "flags8080.h"
+#include "memory8080.h"
 
 struct io_8080;
-
-struct flags_8080 {
-    uint8_t z:1;
-    uint8_t s:1;
-    uint8_t cy:1;
-    uint8_t ac:1;
-    uint8_t p:1;
-    uint8_t pad:3;
-};
-
+struct frame_store_8080;
+struct trace_8080;
+struct profile_8080;
+struct jit_8080;
+struct block_cache_8080;
+struct recomp_8080;
 
 struct state_8080 {
     uint8_t a;
@@ -28,21 +26,109 @@ struct state_8080 {
     uint16_t sp;
     uint16_t pc;
 
-    uint8_t *memory;
+    uint8_t *memory; // MEMORY_HOST_SIZE bytes and a page of zeros, mirrors included
+    struct memory_base_8080 *base; // NULL unless memory is a private view of a frozen copy, see state_fork
+    uint32_t memory_size; // bytes the program sees, the pages past it are unmapped
+    struct page_8080 pages[MEMORY_PAGES];
+    uint32_t map_version; // changes with pages, for whatever keeps a copy of the flags
 
     uint8_t int_enable;
+    uint8_t halted; // HLT ran and pc is still on it, set until an interrupt takes the cpu past it
+
+    uint64_t cycles; // states executed since make_state
 
     uint16_t ram_offset;
 
     struct flags_8080 flags;
+#ifdef LAZY_FLAGS
+    struct lazy_flags_8080 lazy;
+#endif
     struct io_8080 *io;
 
-    uint8_t screen_buffer[SCREEN_WIDTH][SCREEN_HEIGHT][4];
+    // one bit per 8x8 vram tile written since the last gpu_update, a word per tile row
+    uint32_t vram_dirty[SCREEN_WIDTH / 8];
+
+    struct frame_store_8080 *frames; // NULL when nothing displays this instance
+    struct trace_8080 *trace; // NULL unless recording an execution trace
+    struct profile_8080 *profile; // NULL unless counting executions per address
+    struct jit_8080 *jit; // NULL unless translating to host code
+    struct block_cache_8080 *blocks; // NULL unless running from pre-decoded blocks
+    struct recomp_8080 *recomp; // NULL unless the rom was translated to C ahead of time
     void (* update_screen) (struct state_8080 *state);
+
+    struct memory_stats_8080 memory_stats;
+    void (* log_access) (struct state_8080 *state, enum memory_access_8080 access, uint16_t offset); // NULL to only count
 };
 
+// cpu instruction abstractions
+void core8080_add(struct state_8080 *state, uint8_t value);
+
+void core808_adc(struct state_8080 *state, uint8_t value);
+
+void core8080_sub(struct state_8080 *state, uint8_t value);
+
+void core8080_sbb(struct state_8080 *state, uint8_t value);
+
+void core8080_call(struct state_8080 *state, uint16_t addr);
+
+void core8080_ret(struct state_8080 *state);
+
+void core8080_push(struct state_8080 *state, uint8_t hb, uint8_t lb);
+
+uint16_t core8080_pop(struct state_8080 *state);
+
+void core8080_jump(struct state_8080 *state, uint16_t addr);
+
+void core8080_cmp(struct state_8080 *state, uint8_t value);
+
+void core8080_and(struct state_8080 *state, uint8_t value);
+
+void core8080_or(struct state_8080 *state, uint8_t value);
+
+void core8080_xor(struct state_8080 *state, uint8_t value);
+
+void core8080_dad(struct state_8080 *state, uint16_t value);
+
+void core8080_daa(struct state_8080 *state);
+
+// a lookup in the page table and a load or store, anything else goes through memory8080_write
+static inline void core8080_write_byte(struct state_8080 *state, uint16_t offset, uint8_t value) {
+    struct page_8080 *page = &state->pages[offset >> 8];
+
+    if ((page->flags & MEM_SLOW) || state->jit || state->blocks || state->recomp) {
+        memory8080_write(state, offset, value);
+        return;
+    }
+    page->host[offset & 0xff] = value;
+}
+
+static inline uint8_t core8080_read_byte(struct state_8080 *state, uint16_t offset) {
+    return state->pages[offset >> 8].host[offset & 0xff];
+}
+
+void core8080_io_read(struct state_8080 *state, int port);
+void core8080_io_write(struct state_8080 *state, int port);
+
+// util functions
+
+uint8_t pack_flags(struct state_8080 *state);
+
+void unpack_flags(struct state_8080 *state, uint8_t psw);
+
 int cpu_update(struct state_8080 *state);
 
+// executes RST rst as if the interrupt controller had put it on the bus.
+// returns 0 and does nothing while interrupts are disabled
+int cpu_interrupt(struct state_8080 *state, int rst);
+
 int load_bin_file(struct state_8080 *state, int offset, char *file_name);
 struct state_8080 *make_state(int mem_size, uint16_t ram_offset);
+void free_state(struct state_8080 *state);
+
+// a new instance where parent is, sharing its memory until either writes a host page, see
+// memory8080_fork. NULL when the host refuses the memory. ports keep
+// their bytes but no devices, nothing displays, traces or translates it, the recompiled image
+// stays. not thread safe, the caller frees child->io and installs its devices
+struct state_8080 *state_fork(struct state_8080 *parent);
+
 void print_state(struct state_8080 *state);
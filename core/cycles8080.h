@@ -0,0 +1,12 @@
+#ifndef EMULATOR101_CYCLES8080_H
+#define EMULATOR101_CYCLES8080_H
+
+#include <stdint.h>
+
+// states each opcode takes. conditional calls and returns are listed with their not taken cost,
+// taking them costs CYCLES_8080_TAKEN more. conditional jumps cost the same either way
+#define CYCLES_8080_TAKEN 6
+
+extern const uint8_t cycles_8080[256];
+
+#endif //EMULATOR101_CYCLES8080_H
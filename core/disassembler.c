@@ -1,287 +1,376 @@
-#include "stdlib.h"
+#include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+
 #include "disassembler.h"
 
+enum operand_8080 {
+	OPERAND_NONE = 0,
+	OPERAND_BYTE = 1,
+	OPERAND_WORD = 2,
+};
 
-int disassemble_8080(unsigned char *codebuffer, int pc){
-	unsigned char *code = &codebuffer[pc];
-	unsigned int opbytes = 1;
-  printf("%04x ", pc);
-	switch (*code) {
-		case 0x00: printf("NOP"); break;
-		case 0x01: printf("LXI    B,#$%02x%02x", code[2], code[1]); opbytes=3; break;
-		case 0x02: printf("STAX   B"); break;
-		case 0x03: printf("INX    B"); break;
-		case 0x04: printf("INR    B"); break;
-		case 0x05: printf("DCR    B"); break;
-		case 0x06: printf("MVI    B,#$%02x", code[1]); opbytes=2; break;
-		case 0x07: printf("RLC"); break;
-		case 0x08: printf("NOP"); break;
-		case 0x09: printf("DAD    B"); break;
-		case 0x0a: printf("LDAX   B"); break;
-		case 0x0b: printf("DCX    B"); break;
-		case 0x0c: printf("INR    C"); break;
-		case 0x0d: printf("DCR    C"); break;
-		case 0x0e: printf("MVI    C,#$%02x", code[1]); opbytes = 2;	break;
-		case 0x0f: printf("RRC"); break;
-			
-		case 0x10: printf("NOP"); break;
-		case 0x11: printf("LXI    D,#$%02x%02x", code[2], code[1]); opbytes=3; break;
-		case 0x12: printf("STAX   D"); break;
-		case 0x13: printf("INX    D"); break;
-		case 0x14: printf("INR    D"); break;
-		case 0x15: printf("DCR    D"); break;
-		case 0x16: printf("MVI    D,#$%02x", code[1]); opbytes=2; break;
-		case 0x17: printf("RAL"); break;
-		case 0x18: printf("NOP"); break;
-		case 0x19: printf("DAD    D"); break;
-		case 0x1a: printf("LDAX   D"); break;
-		case 0x1b: printf("DCX    D"); break;
-		case 0x1c: printf("INR    E"); break;
-		case 0x1d: printf("DCR    E"); break;
-		case 0x1e: printf("MVI    E,#$%02x", code[1]); opbytes = 2; break;
-		case 0x1f: printf("RAR"); break;
-			
-		case 0x20: printf("NOP"); break;
-		case 0x21: printf("LXI    H,#$%02x%02x", code[2], code[1]); opbytes=3; break;
-		case 0x22: printf("SHLD   $%02x%02x", code[2], code[1]); opbytes=3; break;
-		case 0x23: printf("INX    H"); break;
-		case 0x24: printf("INR    H"); break;
-		case 0x25: printf("DCR    H"); break;
-		case 0x26: printf("MVI    H,#$%02x", code[1]); opbytes=2; break;
-		case 0x27: printf("DAA"); break;
-		case 0x28: printf("NOP"); break;
-		case 0x29: printf("DAD    H"); break;
-		case 0x2a: printf("LHLD   $%02x%02x", code[2], code[1]); opbytes=3; break;
-		case 0x2b: printf("DCX    H"); break;
-		case 0x2c: printf("INR    L"); break;
-		case 0x2d: printf("DCR    L"); break;
-		case 0x2e: printf("MVI    L,#$%02x", code[1]); opbytes = 2; break;
-		case 0x2f: printf("CMA"); break;
-			
-		case 0x30: printf("NOP"); break;
-		case 0x31: printf("LXI    SP,#$%02x%02x", code[2], code[1]); opbytes=3; break;
-		case 0x32: printf("STA    $%02x%02x", code[2], code[1]); opbytes=3; break;
-		case 0x33: printf("INX    SP"); break;
-		case 0x34: printf("INR    M"); break;
-		case 0x35: printf("DCR    M"); break;
-		case 0x36: printf("MVI    M,#$%02x", code[1]); opbytes=2; break;
-		case 0x37: printf("STC"); break;
-		case 0x38: printf("NOP"); break;
-		case 0x39: printf("DAD    SP"); break;
-		case 0x3a: printf("LDA    $%02x%02x", code[2], code[1]); opbytes=3; break;
-		case 0x3b: printf("DCX    SP"); break;
-		case 0x3c: printf("INR    A"); break;
-		case 0x3d: printf("DCR    A"); break;
-		case 0x3e: printf("MVI    A,#$%02x", code[1]); opbytes = 2; break;
-		case 0x3f: printf("CMC"); break;
-			
-		case 0x40: printf("MOV    B,B"); break;
-		case 0x41: printf("MOV    B,C"); break;
-		case 0x42: printf("MOV    B,D"); break;
-		case 0x43: printf("MOV    B,E"); break;
-		case 0x44: printf("MOV    B,H"); break;
-		case 0x45: printf("MOV    B,L"); break;
-		case 0x46: printf("MOV    B,M"); break;
-		case 0x47: printf("MOV    B,A"); break;
-		case 0x48: printf("MOV    C,B"); break;
-		case 0x49: printf("MOV    C,C"); break;
-		case 0x4a: printf("MOV    C,D"); break;
-		case 0x4b: printf("MOV    C,E"); break;
-		case 0x4c: printf("MOV    C,H"); break;
-		case 0x4d: printf("MOV    C,L"); break;
-		case 0x4e: printf("MOV    C,M"); break;
-		case 0x4f: printf("MOV    C,A"); break;
-			
-		case 0x50: printf("MOV    D,B"); break;
-		case 0x51: printf("MOV    D,C"); break;
-		case 0x52: printf("MOV    D,D"); break;
-		case 0x53: printf("MOV    D.E"); break;
-		case 0x54: printf("MOV    D,H"); break;
-		case 0x55: printf("MOV    D,L"); break;
-		case 0x56: printf("MOV    D,M"); break;
-		case 0x57: printf("MOV    D,A"); break;
-		case 0x58: printf("MOV    E,B"); break;
-		case 0x59: printf("MOV    E,C"); break;
-		case 0x5a: printf("MOV    E,D"); break;
-		case 0x5b: printf("MOV    E,E"); break;
-		case 0x5c: printf("MOV    E,H"); break;
-		case 0x5d: printf("MOV    E,L"); break;
-		case 0x5e: printf("MOV    E,M"); break;
-		case 0x5f: printf("MOV    E,A"); break;
-
-		case 0x60: printf("MOV    H,B"); break;
-		case 0x61: printf("MOV    H,C"); break;
-		case 0x62: printf("MOV    H,D"); break;
-		case 0x63: printf("MOV    H.E"); break;
-		case 0x64: printf("MOV    H,H"); break;
-		case 0x65: printf("MOV    H,L"); break;
-		case 0x66: printf("MOV    H,M"); break;
-		case 0x67: printf("MOV    H,A"); break;
-		case 0x68: printf("MOV    L,B"); break;
-		case 0x69: printf("MOV    L,C"); break;
-		case 0x6a: printf("MOV    L,D"); break;
-		case 0x6b: printf("MOV    L,E"); break;
-		case 0x6c: printf("MOV    L,H"); break;
-		case 0x6d: printf("MOV    L,L"); break;
-		case 0x6e: printf("MOV    L,M"); break;
-		case 0x6f: printf("MOV    L,A"); break;
-
-		case 0x70: printf("MOV    M,B"); break;
-		case 0x71: printf("MOV    M,C"); break;
-		case 0x72: printf("MOV    M,D"); break;
-		case 0x73: printf("MOV    M.E"); break;
-		case 0x74: printf("MOV    M,H"); break;
-		case 0x75: printf("MOV    M,L"); break;
-		case 0x76: printf("HLT");        break;
-		case 0x77: printf("MOV    M,A"); break;
-		case 0x78: printf("MOV    A,B"); break;
-		case 0x79: printf("MOV    A,C"); break;
-		case 0x7a: printf("MOV    A,D"); break;
-		case 0x7b: printf("MOV    A,E"); break;
-		case 0x7c: printf("MOV    A,H"); break;
-		case 0x7d: printf("MOV    A,L"); break;
-		case 0x7e: printf("MOV    A,M"); break;
-		case 0x7f: printf("MOV    A,A"); break;
-
-		case 0x80: printf("ADD    B"); break;
-		case 0x81: printf("ADD    C"); break;
-		case 0x82: printf("ADD    D"); break;
-		case 0x83: printf("ADD    E"); break;
-		case 0x84: printf("ADD    H"); break;
-		case 0x85: printf("ADD    L"); break;
-		case 0x86: printf("ADD    M"); break;
-		case 0x87: printf("ADD    A"); break;
-		case 0x88: printf("ADC    B"); break;
-		case 0x89: printf("ADC    C"); break;
-		case 0x8a: printf("ADC    D"); break;
-		case 0x8b: printf("ADC    E"); break;
-		case 0x8c: printf("ADC    H"); break;
-		case 0x8d: printf("ADC    L"); break;
-		case 0x8e: printf("ADC    M"); break;
-		case 0x8f: printf("ADC    A"); break;
-
-		case 0x90: printf("SUB    B"); break;
-		case 0x91: printf("SUB    C"); break;
-		case 0x92: printf("SUB    D"); break;
-		case 0x93: printf("SUB    E"); break;
-		case 0x94: printf("SUB    H"); break;
-		case 0x95: printf("SUB    L"); break;
-		case 0x96: printf("SUB    M"); break;
-		case 0x97: printf("SUB    A"); break;
-		case 0x98: printf("SBB    B"); break;
-		case 0x99: printf("SBB    C"); break;
-		case 0x9a: printf("SBB    D"); break;
-		case 0x9b: printf("SBB    E"); break;
-		case 0x9c: printf("SBB    H"); break;
-		case 0x9d: printf("SBB    L"); break;
-		case 0x9e: printf("SBB    M"); break;
-		case 0x9f: printf("SBB    A"); break;
-
-		case 0xa0: printf("ANA    B"); break;
-		case 0xa1: printf("ANA    C"); break;
-		case 0xa2: printf("ANA    D"); break;
-		case 0xa3: printf("ANA    E"); break;
-		case 0xa4: printf("ANA    H"); break;
-		case 0xa5: printf("ANA    L"); break;
-		case 0xa6: printf("ANA    M"); break;
-		case 0xa7: printf("ANA    A"); break;
-		case 0xa8: printf("XRA    B"); break;
-		case 0xa9: printf("XRA    C"); break;
-		case 0xaa: printf("XRA    D"); break;
-		case 0xab: printf("XRA    E"); break;
-		case 0xac: printf("XRA    H"); break;
-		case 0xad: printf("XRA    L"); break;
-		case 0xae: printf("XRA    M"); break;
-		case 0xaf: printf("XRA    A"); break;
-
-		case 0xb0: printf("ORA    B"); break;
-		case 0xb1: printf("ORA    C"); break;
-		case 0xb2: printf("ORA    D"); break;
-		case 0xb3: printf("ORA    E"); break;
-		case 0xb4: printf("ORA    H"); break;
-		case 0xb5: printf("ORA    L"); break;
-		case 0xb6: printf("ORA    M"); break;
-		case 0xb7: printf("ORA    A"); break;
-		case 0xb8: printf("CMP    B"); break;
-		case 0xb9: printf("CMP    C"); break;
-		case 0xba: printf("CMP    D"); break;
-		case 0xbb: printf("CMP    E"); break;
-		case 0xbc: printf("CMP    H"); break;
-		case 0xbd: printf("CMP    L"); break;
-		case 0xbe: printf("CMP    M"); break;
-		case 0xbf: printf("CMP    A"); break;
-
-		case 0xc0: printf("RNZ"); break;
-		case 0xc1: printf("POP    B"); break;
-		case 0xc2: printf("JNZ    $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xc3: printf("JMP    $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xc4: printf("CNZ    $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xc5: printf("PUSH   B"); break;
-		case 0xc6: printf("ADI    #$%02x",code[1]); opbytes = 2; break;
-		case 0xc7: printf("RST    0"); break;
-		case 0xc8: printf("RZ"); break;
-		case 0xc9: printf("RET"); break;
-		case 0xca: printf("JZ     $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xcb: printf("JMP    $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xcc: printf("CZ     $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xcd: printf("CALL   $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xce: printf("ACI    #$%02x",code[1]); opbytes = 2; break;
-		case 0xcf: printf("RST    1"); break;
-
-		case 0xd0: printf("RNC"); break;
-		case 0xd1: printf("POP    D"); break;
-		case 0xd2: printf("JNC    $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xd3: printf("OUT    #$%02x",code[1]); opbytes = 2; break;
-		case 0xd4: printf("CNC    $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xd5: printf("PUSH   D"); break;
-		case 0xd6: printf("SUI    #$%02x",code[1]); opbytes = 2; break;
-		case 0xd7: printf("RST    2"); break;
-		case 0xd8: printf("RC");  break;
-		case 0xd9: printf("RET"); break;
-		case 0xda: printf("JC     $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xdb: printf("IN     #$%02x",code[1]); opbytes = 2; break;
-		case 0xdc: printf("CC     $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xdd: printf("CALL   $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xde: printf("SBI    #$%02x",code[1]); opbytes = 2; break;
-		case 0xdf: printf("RST    3"); break;
-
-		case 0xe0: printf("RPO"); break;
-		case 0xe1: printf("POP    H"); break;
-		case 0xe2: printf("JPO    $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xe3: printf("XTHL");break;
-		case 0xe4: printf("CPO    $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xe5: printf("PUSH   H"); break;
-		case 0xe6: printf("ANI    #$%02x",code[1]); opbytes = 2; break;
-		case 0xe7: printf("RST    4"); break;
-		case 0xe8: printf("RPE"); break;
-		case 0xe9: printf("PCHL");break;
-		case 0xea: printf("JPE    $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xeb: printf("XCHG"); break;
-		case 0xec: printf("CPE     $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xed: printf("CALL   $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xee: printf("XRI    #$%02x",code[1]); opbytes = 2; break;
-		case 0xef: printf("RST    5"); break;
-
-		case 0xf0: printf("RP");  break;
-		case 0xf1: printf("POP    PSW"); break;
-		case 0xf2: printf("JP     $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xf3: printf("DI");  break;
-		case 0xf4: printf("CP     $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xf5: printf("PUSH   PSW"); break;
-		case 0xf6: printf("ORI    #$%02x",code[1]); opbytes = 2; break;
-		case 0xf7: printf("RST    6"); break;
-		case 0xf8: printf("RM");  break;
-		case 0xf9: printf("SPHL");break;
-		case 0xfa: printf("JM     $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xfb: printf("EI");  break;
-		case 0xfc: printf("CM     $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xfd: printf("CALL   $%02x%02x",code[2],code[1]); opbytes = 3; break;
-		case 0xfe: printf("CPI    #$%02x",code[1]); opbytes = 2; break;
-		case 0xff: printf("RST    7"); break;
+// everything up to the operand, which is always hex and always last
+struct mnemonic_8080 {
+	const char *text;
+	uint8_t operand;
+};
+
+static const struct mnemonic_8080 mnemonics[256] = {
+		[0x00] = {"NOP", OPERAND_NONE},
+		[0x01] = {"LXI    B,#$", OPERAND_WORD},
+		[0x02] = {"STAX   B", OPERAND_NONE},
+		[0x03] = {"INX    B", OPERAND_NONE},
+		[0x04] = {"INR    B", OPERAND_NONE},
+		[0x05] = {"DCR    B", OPERAND_NONE},
+		[0x06] = {"MVI    B,#$", OPERAND_BYTE},
+		[0x07] = {"RLC", OPERAND_NONE},
+		[0x08] = {"NOP", OPERAND_NONE},
+		[0x09] = {"DAD    B", OPERAND_NONE},
+		[0x0a] = {"LDAX   B", OPERAND_NONE},
+		[0x0b] = {"DCX    B", OPERAND_NONE},
+		[0x0c] = {"INR    C", OPERAND_NONE},
+		[0x0d] = {"DCR    C", OPERAND_NONE},
+		[0x0e] = {"MVI    C,#$", OPERAND_BYTE},
+		[0x0f] = {"RRC", OPERAND_NONE},
+
+		[0x10] = {"NOP", OPERAND_NONE},
+		[0x11] = {"LXI    D,#$", OPERAND_WORD},
+		[0x12] = {"STAX   D", OPERAND_NONE},
+		[0x13] = {"INX    D", OPERAND_NONE},
+		[0x14] = {"INR    D", OPERAND_NONE},
+		[0x15] = {"DCR    D", OPERAND_NONE},
+		[0x16] = {"MVI    D,#$", OPERAND_BYTE},
+		[0x17] = {"RAL", OPERAND_NONE},
+		[0x18] = {"NOP", OPERAND_NONE},
+		[0x19] = {"DAD    D", OPERAND_NONE},
+		[0x1a] = {"LDAX   D", OPERAND_NONE},
+		[0x1b] = {"DCX    D", OPERAND_NONE},
+		[0x1c] = {"INR    E", OPERAND_NONE},
+		[0x1d] = {"DCR    E", OPERAND_NONE},
+		[0x1e] = {"MVI    E,#$", OPERAND_BYTE},
+		[0x1f] = {"RAR", OPERAND_NONE},
+
+		[0x20] = {"NOP", OPERAND_NONE},
+		[0x21] = {"LXI    H,#$", OPERAND_WORD},
+		[0x22] = {"SHLD   $", OPERAND_WORD},
+		[0x23] = {"INX    H", OPERAND_NONE},
+		[0x24] = {"INR    H", OPERAND_NONE},
+		[0x25] = {"DCR    H", OPERAND_NONE},
+		[0x26] = {"MVI    H,#$", OPERAND_BYTE},
+		[0x27] = {"DAA", OPERAND_NONE},
+		[0x28] = {"NOP", OPERAND_NONE},
+		[0x29] = {"DAD    H", OPERAND_NONE},
+		[0x2a] = {"LHLD   $", OPERAND_WORD},
+		[0x2b] = {"DCX    H", OPERAND_NONE},
+		[0x2c] = {"INR    L", OPERAND_NONE},
+		[0x2d] = {"DCR    L", OPERAND_NONE},
+		[0x2e] = {"MVI    L,#$", OPERAND_BYTE},
+		[0x2f] = {"CMA", OPERAND_NONE},
+
+		[0x30] = {"NOP", OPERAND_NONE},
+		[0x31] = {"LXI    SP,#$", OPERAND_WORD},
+		[0x32] = {"STA    $", OPERAND_WORD},
+		[0x33] = {"INX    SP", OPERAND_NONE},
+		[0x34] = {"INR    M", OPERAND_NONE},
+		[0x35] = {"DCR    M", OPERAND_NONE},
+		[0x36] = {"MVI    M,#$", OPERAND_BYTE},
+		[0x37] = {"STC", OPERAND_NONE},
+		[0x38] = {"NOP", OPERAND_NONE},
+		[0x39] = {"DAD    SP", OPERAND_NONE},
+		[0x3a] = {"LDA    $", OPERAND_WORD},
+		[0x3b] = {"DCX    SP", OPERAND_NONE},
+		[0x3c] = {"INR    A", OPERAND_NONE},
+		[0x3d] = {"DCR    A", OPERAND_NONE},
+		[0x3e] = {"MVI    A,#$", OPERAND_BYTE},
+		[0x3f] = {"CMC", OPERAND_NONE},
+
+		[0x40] = {"MOV    B,B", OPERAND_NONE},
+		[0x41] = {"MOV    B,C", OPERAND_NONE},
+		[0x42] = {"MOV    B,D", OPERAND_NONE},
+		[0x43] = {"MOV    B,E", OPERAND_NONE},
+		[0x44] = {"MOV    B,H", OPERAND_NONE},
+		[0x45] = {"MOV    B,L", OPERAND_NONE},
+		[0x46] = {"MOV    B,M", OPERAND_NONE},
+		[0x47] = {"MOV    B,A", OPERAND_NONE},
+		[0x48] = {"MOV    C,B", OPERAND_NONE},
+		[0x49] = {"MOV    C,C", OPERAND_NONE},
+		[0x4a] = {"MOV    C,D", OPERAND_NONE},
+		[0x4b] = {"MOV    C,E", OPERAND_NONE},
+		[0x4c] = {"MOV    C,H", OPERAND_NONE},
+		[0x4d] = {"MOV    C,L", OPERAND_NONE},
+		[0x4e] = {"MOV    C,M", OPERAND_NONE},
+		[0x4f] = {"MOV    C,A", OPERAND_NONE},
+
+		[0x50] = {"MOV    D,B", OPERAND_NONE},
+		[0x51] = {"MOV    D,C", OPERAND_NONE},
+		[0x52] = {"MOV    D,D", OPERAND_NONE},
+		[0x53] = {"MOV    D,E", OPERAND_NONE},
+		[0x54] = {"MOV    D,H", OPERAND_NONE},
+		[0x55] = {"MOV    D,L", OPERAND_NONE},
+		[0x56] = {"MOV    D,M", OPERAND_NONE},
+		[0x57] = {"MOV    D,A", OPERAND_NONE},
+		[0x58] = {"MOV    E,B", OPERAND_NONE},
+		[0x59] = {"MOV    E,C", OPERAND_NONE},
+		[0x5a] = {"MOV    E,D", OPERAND_NONE},
+		[0x5b] = {"MOV    E,E", OPERAND_NONE},
+		[0x5c] = {"MOV    E,H", OPERAND_NONE},
+		[0x5d] = {"MOV    E,L", OPERAND_NONE},
+		[0x5e] = {"MOV    E,M", OPERAND_NONE},
+		[0x5f] = {"MOV    E,A", OPERAND_NONE},
+
+		[0x60] = {"MOV    H,B", OPERAND_NONE},
+		[0x61] = {"MOV    H,C", OPERAND_NONE},
+		[0x62] = {"MOV    H,D", OPERAND_NONE},
+		[0x63] = {"MOV    H,E", OPERAND_NONE},
+		[0x64] = {"MOV    H,H", OPERAND_NONE},
+		[0x65] = {"MOV    H,L", OPERAND_NONE},
+		[0x66] = {"MOV    H,M", OPERAND_NONE},
+		[0x67] = {"MOV    H,A", OPERAND_NONE},
+		[0x68] = {"MOV    L,B", OPERAND_NONE},
+		[0x69] = {"MOV    L,C", OPERAND_NONE},
+		[0x6a] = {"MOV    L,D", OPERAND_NONE},
+		[0x6b] = {"MOV    L,E", OPERAND_NONE},
+		[0x6c] = {"MOV    L,H", OPERAND_NONE},
+		[0x6d] = {"MOV    L,L", OPERAND_NONE},
+		[0x6e] = {"MOV    L,M", OPERAND_NONE},
+		[0x6f] = {"MOV    L,A", OPERAND_NONE},
+
+		[0x70] = {"MOV    M,B", OPERAND_NONE},
+		[0x71] = {"MOV    M,C", OPERAND_NONE},
+		[0x72] = {"MOV    M,D", OPERAND_NONE},
+		[0x73] = {"MOV    M,E", OPERAND_NONE},
+		[0x74] = {"MOV    M,H", OPERAND_NONE},
+		[0x75] = {"MOV    M,L", OPERAND_NONE},
+		[0x76] = {"HLT", OPERAND_NONE},
+		[0x77] = {"MOV    M,A", OPERAND_NONE},
+		[0x78] = {"MOV    A,B", OPERAND_NONE},
+		[0x79] = {"MOV    A,C", OPERAND_NONE},
+		[0x7a] = {"MOV    A,D", OPERAND_NONE},
+		[0x7b] = {"MOV    A,E", OPERAND_NONE},
+		[0x7c] = {"MOV    A,H", OPERAND_NONE},
+		[0x7d] = {"MOV    A,L", OPERAND_NONE},
+		[0x7e] = {"MOV    A,M", OPERAND_NONE},
+		[0x7f] = {"MOV    A,A", OPERAND_NONE},
+
+		[0x80] = {"ADD    B", OPERAND_NONE},
+		[0x81] = {"ADD    C", OPERAND_NONE},
+		[0x82] = {"ADD    D", OPERAND_NONE},
+		[0x83] = {"ADD    E", OPERAND_NONE},
+		[0x84] = {"ADD    H", OPERAND_NONE},
+		[0x85] = {"ADD    L", OPERAND_NONE},
+		[0x86] = {"ADD    M", OPERAND_NONE},
+		[0x87] = {"ADD    A", OPERAND_NONE},
+		[0x88] = {"ADC    B", OPERAND_NONE},
+		[0x89] = {"ADC    C", OPERAND_NONE},
+		[0x8a] = {"ADC    D", OPERAND_NONE},
+		[0x8b] = {"ADC    E", OPERAND_NONE},
+		[0x8c] = {"ADC    H", OPERAND_NONE},
+		[0x8d] = {"ADC    L", OPERAND_NONE},
+		[0x8e] = {"ADC    M", OPERAND_NONE},
+		[0x8f] = {"ADC    A", OPERAND_NONE},
+
+		[0x90] = {"SUB    B", OPERAND_NONE},
+		[0x91] = {"SUB    C", OPERAND_NONE},
+		[0x92] = {"SUB    D", OPERAND_NONE},
+		[0x93] = {"SUB    E", OPERAND_NONE},
+		[0x94] = {"SUB    H", OPERAND_NONE},
+		[0x95] = {"SUB    L", OPERAND_NONE},
+		[0x96] = {"SUB    M", OPERAND_NONE},
+		[0x97] = {"SUB    A", OPERAND_NONE},
+		[0x98] = {"SBB    B", OPERAND_NONE},
+		[0x99] = {"SBB    C", OPERAND_NONE},
+		[0x9a] = {"SBB    D", OPERAND_NONE},
+		[0x9b] = {"SBB    E", OPERAND_NONE},
+		[0x9c] = {"SBB    H", OPERAND_NONE},
+		[0x9d] = {"SBB    L", OPERAND_NONE},
+		[0x9e] = {"SBB    M", OPERAND_NONE},
+		[0x9f] = {"SBB    A", OPERAND_NONE},
+
+		[0xa0] = {"ANA    B", OPERAND_NONE},
+		[0xa1] = {"ANA    C", OPERAND_NONE},
+		[0xa2] = {"ANA    D", OPERAND_NONE},
+		[0xa3] = {"ANA    E", OPERAND_NONE},
+		[0xa4] = {"ANA    H", OPERAND_NONE},
+		[0xa5] = {"ANA    L", OPERAND_NONE},
+		[0xa6] = {"ANA    M", OPERAND_NONE},
+		[0xa7] = {"ANA    A", OPERAND_NONE},
+		[0xa8] = {"XRA    B", OPERAND_NONE},
+		[0xa9] = {"XRA    C", OPERAND_NONE},
+		[0xaa] = {"XRA    D", OPERAND_NONE},
+		[0xab] = {"XRA    E", OPERAND_NONE},
+		[0xac] = {"XRA    H", OPERAND_NONE},
+		[0xad] = {"XRA    L", OPERAND_NONE},
+		[0xae] = {"XRA    M", OPERAND_NONE},
+		[0xaf] = {"XRA    A", OPERAND_NONE},
+
+		[0xb0] = {"ORA    B", OPERAND_NONE},
+		[0xb1] = {"ORA    C", OPERAND_NONE},
+		[0xb2] = {"ORA    D", OPERAND_NONE},
+		[0xb3] = {"ORA    E", OPERAND_NONE},
+		[0xb4] = {"ORA    H", OPERAND_NONE},
+		[0xb5] = {"ORA    L", OPERAND_NONE},
+		[0xb6] = {"ORA    M", OPERAND_NONE},
+		[0xb7] = {"ORA    A", OPERAND_NONE},
+		[0xb8] = {"CMP    B", OPERAND_NONE},
+		[0xb9] = {"CMP    C", OPERAND_NONE},
+		[0xba] = {"CMP    D", OPERAND_NONE},
+		[0xbb] = {"CMP    E", OPERAND_NONE},
+		[0xbc] = {"CMP    H", OPERAND_NONE},
+		[0xbd] = {"CMP    L", OPERAND_NONE},
+		[0xbe] = {"CMP    M", OPERAND_NONE},
+		[0xbf] = {"CMP    A", OPERAND_NONE},
+
+		[0xc0] = {"RNZ", OPERAND_NONE},
+		[0xc1] = {"POP    B", OPERAND_NONE},
+		[0xc2] = {"JNZ    $", OPERAND_WORD},
+		[0xc3] = {"JMP    $", OPERAND_WORD},
+		[0xc4] = {"CNZ    $", OPERAND_WORD},
+		[0xc5] = {"PUSH   B", OPERAND_NONE},
+		[0xc6] = {"ADI    #$", OPERAND_BYTE},
+		[0xc7] = {"RST    0", OPERAND_NONE},
+		[0xc8] = {"RZ", OPERAND_NONE},
+		[0xc9] = {"RET", OPERAND_NONE},
+		[0xca] = {"JZ     $", OPERAND_WORD},
+		[0xcb] = {"JMP    $", OPERAND_WORD},
+		[0xcc] = {"CZ     $", OPERAND_WORD},
+		[0xcd] = {"CALL   $", OPERAND_WORD},
+		[0xce] = {"ACI    #$", OPERAND_BYTE},
+		[0xcf] = {"RST    1", OPERAND_NONE},
+
+		[0xd0] = {"RNC", OPERAND_NONE},
+		[0xd1] = {"POP    D", OPERAND_NONE},
+		[0xd2] = {"JNC    $", OPERAND_WORD},
+		[0xd3] = {"OUT    #$", OPERAND_BYTE},
+		[0xd4] = {"CNC    $", OPERAND_WORD},
+		[0xd5] = {"PUSH   D", OPERAND_NONE},
+		[0xd6] = {"SUI    #$", OPERAND_BYTE},
+		[0xd7] = {"RST    2", OPERAND_NONE},
+		[0xd8] = {"RC", OPERAND_NONE},
+		[0xd9] = {"RET", OPERAND_NONE},
+		[0xda] = {"JC     $", OPERAND_WORD},
+		[0xdb] = {"IN     #$", OPERAND_BYTE},
+		[0xdc] = {"CC     $", OPERAND_WORD},
+		[0xdd] = {"CALL   $", OPERAND_WORD},
+		[0xde] = {"SBI    #$", OPERAND_BYTE},
+		[0xdf] = {"RST    3", OPERAND_NONE},
+
+		[0xe0] = {"RPO", OPERAND_NONE},
+		[0xe1] = {"POP    H", OPERAND_NONE},
+		[0xe2] = {"JPO    $", OPERAND_WORD},
+		[0xe3] = {"XTHL", OPERAND_NONE},
+		[0xe4] = {"CPO    $", OPERAND_WORD},
+		[0xe5] = {"PUSH   H", OPERAND_NONE},
+		[0xe6] = {"ANI    #$", OPERAND_BYTE},
+		[0xe7] = {"RST    4", OPERAND_NONE},
+		[0xe8] = {"RPE", OPERAND_NONE},
+		[0xe9] = {"PCHL", OPERAND_NONE},
+		[0xea] = {"JPE    $", OPERAND_WORD},
+		[0xeb] = {"XCHG", OPERAND_NONE},
+		[0xec] = {"CPE    $", OPERAND_WORD},
+		[0xed] = {"CALL   $", OPERAND_WORD},
+		[0xee] = {"XRI    #$", OPERAND_BYTE},
+		[0xef] = {"RST    5", OPERAND_NONE},
+
+		[0xf0] = {"RP", OPERAND_NONE},
+		[0xf1] = {"POP    PSW", OPERAND_NONE},
+		[0xf2] = {"JP     $", OPERAND_WORD},
+		[0xf3] = {"DI", OPERAND_NONE},
+		[0xf4] = {"CP     $", OPERAND_WORD},
+		[0xf5] = {"PUSH   PSW", OPERAND_NONE},
+		[0xf6] = {"ORI    #$", OPERAND_BYTE},
+		[0xf7] = {"RST    6", OPERAND_NONE},
+		[0xf8] = {"RM", OPERAND_NONE},
+		[0xf9] = {"SPHL", OPERAND_NONE},
+		[0xfa] = {"JM     $", OPERAND_WORD},
+		[0xfb] = {"EI", OPERAND_NONE},
+		[0xfc] = {"CM     $", OPERAND_WORD},
+		[0xfd] = {"CALL   $", OPERAND_WORD},
+		[0xfe] = {"CPI    #$", OPERAND_BYTE},
+		[0xff] = {"RST    7", OPERAND_NONE},
+};
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static char *put_hex(char *out, unsigned value, int digits) {
+	for (int i = digits - 1; i >= 0; i--) {
+		*out++ = hex_digits[(value >> (i * 4)) & 0xf];
+	}
+	return out;
+}
+
+// formats the instruction at code, which sits at pc, into out without a terminator.
+// out needs DISASSEMBLE_LINE_MAX bytes, returns the number written
+static size_t format_instruction(char *out, const uint8_t *code, int pc, int *opbytes) {
+	const struct mnemonic_8080 *mnemonic = &mnemonics[code[0]];
+	char *end = put_hex(out, pc, 4);
+	size_t text_length = strlen(mnemonic->text);
+
+	*end++ = ' ';
+	memcpy(end, mnemonic->text, text_length);
+	end += text_length;
+	if (mnemonic->operand == OPERAND_BYTE) end = put_hex(end, code[1], 2);
+	if (mnemonic->operand == OPERAND_WORD) end = put_hex(end, code[2] << 8 | code[1], 4);
+
+	*opbytes = mnemonic->operand + 1;
+	return end - out;
+}
+
+int disassemble_8080_to(char *buffer, size_t length, const uint8_t *memory, int pc) {
+	char line[DISASSEMBLE_LINE_MAX];
+	int opbytes;
+	size_t written = format_instruction(line, &memory[pc], pc, &opbytes);
+
+	if (length == 0) return opbytes;
+	if (written > length - 1) written = length - 1;
+	memcpy(buffer, line, written);
+	buffer[written] = '\0';
+	return opbytes;
+}
+
+int disassemble_8080_opcode(char *buffer, size_t length, uint8_t opcode) {
+	static const char *operands[] = {"", "d8", "d16"};
+	const struct mnemonic_8080 *mnemonic = &mnemonics[opcode];
+	char line[DISASSEMBLE_LINE_MAX + 1];
+	int written = snprintf(line, sizeof(line), "%s%s", mnemonic->text, operands[mnemonic->operand]);
+
+	if (length == 0) return mnemonic->operand + 1;
+	if (written > (int) length - 1) written = length - 1;
+	memcpy(buffer, line, written);
+	buffer[written] = '\0';
+	return mnemonic->operand + 1;
+}
+
+size_t disassemble_8080_range(char *buffer, size_t length, const uint8_t *memory, int start, int end, int *next) {
+	size_t written = 0;
+	int pc = start;
+
+	while (pc < end && written + DISASSEMBLE_LINE_MAX + 1 <= length) {
+		const uint8_t *code = &memory[pc];
+		uint8_t tail[3] = {0, 0, 0};
+		int opbytes;
+
+		// an instruction cut off by end gets zeros for the bytes past it instead of reading them
+		if (end - pc < 3) {
+			memcpy(tail, code, end - pc);
+			code = tail;
+		}
+		written += format_instruction(buffer + written, code, pc, &opbytes);
+		buffer[written++] = '\n';
+		pc += opbytes;
 	}
-	
-	printf("\n");
+	if (length > 0) buffer[written < length ? written : length - 1] = '\0';
+	if (next) *next = pc;
+	return written;
+}
+
+int disassemble_8080(unsigned char *codebuffer, int pc){
+	char line[DISASSEMBLE_LINE_MAX + 1];
+	int opbytes;
+	size_t written = format_instruction(line, &codebuffer[pc], pc, &opbytes);
+
+	line[written++] = '\n';
+	fwrite(line, 1, written, stdout);
 	return opbytes;
 }
 
@@ -300,13 +389,16 @@ int from_file(char *file_name) {
 	unsigned char *buffer = malloc(fsize);
 	fread(buffer, fsize, 1, fd);
 	fclose(fd);
-	int pc = 0;
 
 	printf("fsize=%d\n", fsize);
 
-	while (pc < fsize) {
-		pc += disassemble_8080(buffer, pc);
-		printf("\n");
-	}
+	// one line per byte is the most a listing can take
+	size_t length = (size_t) fsize * DISASSEMBLE_LINE_MAX + 1;
+	char *listing = malloc(length);
+	size_t written = disassemble_8080_range(listing, length, buffer, 0, fsize, NULL);
+	fwrite(listing, 1, written, stdout);
+
+	free(listing);
+	free(buffer);
 	return 0;
 }
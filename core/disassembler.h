@@ -1 +1,21 @@
+#include <stdint.h>
+#include <stddef.h>
+
+// longest line the formatters produce, without newline or terminator
+#define DISASSEMBLE_LINE_MAX 24
+
 int disassemble_8080(unsigned char *buffer, int pc);
+
+// formats the instruction at memory[pc] as disassemble_8080 prints it, without the newline,
+// into buffer. truncates to length - 1 characters and always terminates.
+// returns the instruction length. no locale, no shared state, safe from any thread
+int disassemble_8080_to(char *buffer, size_t length, const uint8_t *memory, int pc);
+
+// lists memory[start, end) a line per instruction into buffer, stopping early when the next line
+// would not fit. (end - start) * DISASSEMBLE_LINE_MAX + 1 bytes always hold the whole range.
+// returns the characters written, terminator excluded. next (may be NULL) gets the pc to resume from
+size_t disassemble_8080_range(char *buffer, size_t length, const uint8_t *memory, int start, int end, int *next);
+
+// the mnemonic of opcode with its operand written as d8 or d16, e.g. "MVI    B,#$d8", for tables
+// keyed by opcode rather than address. same truncation and return value as disassemble_8080_to
+int disassemble_8080_opcode(char *buffer, size_t length, uint8_t opcode);
@@ -0,0 +1,24 @@
+#include <stdint.h>
+
+#include "flags8080.h"
+
+// the table is built by the preprocessor so it lives in .rodata and needs no init call
+#define PARITY(n) (!(((n) ^ (n) >> 1 ^ (n) >> 2 ^ (n) >> 3 ^ (n) >> 4 ^ (n) >> 5 ^ (n) >> 6 ^ (n) >> 7) & 1))
+
+#define F(n) { \
+        .z = ((n) & 0xff) == 0, \
+        .s = ((n) >> 7) & 1, \
+        .cy = ((n) >> 8) & 1, \
+        .ac = 0, \
+        .p = PARITY(n), \
+        .pad = 0 \
+    }
+
+#define F4(n) F(n), F((n) + 1), F((n) + 2), F((n) + 3)
+#define F16(n) F4(n), F4((n) + 4), F4((n) + 8), F4((n) + 12)
+#define F64(n) F16(n), F16((n) + 16), F16((n) + 32), F16((n) + 48)
+#define F256(n) F64(n), F64((n) + 64), F64((n) + 128), F64((n) + 192)
+
+const struct flags_8080 flags8080_table[512] = {
+        F256(0), F256(256)
+};
@@ -0,0 +1,140 @@
+#ifndef EMULATOR101_FLAGS8080_H
+#define EMULATOR101_FLAGS8080_H
+
+#include <stdint.h>
+
+struct flags_8080 {
+    uint8_t z:1;
+    uint8_t s:1;
+    uint8_t cy:1;
+    uint8_t ac:1;
+    uint8_t p:1;
+    uint8_t pad:3;
+};
+
+// z, s, p and cy for every 9 bit alu result.
+// the low 256 entries have cy clear and double as the z/s/p table for 8 bit results
+extern const struct flags_8080 flags8080_table[512];
+
+// add, adc. result is the unmasked sum
+static inline void flags8080_add(struct flags_8080 *flags, uint8_t a, uint8_t value, uint16_t result) {
+    *flags = flags8080_table[result & 0x1ff];
+    flags->ac = ((a ^ value ^ result) >> 4) & 1;
+}
+
+// sub, sbb, cmp. result is the unmasked difference, bit 8 is the borrow.
+// the 8080 subtracts by adding the complement so ac is the inverted half borrow
+static inline void flags8080_sub(struct flags_8080 *flags, uint8_t a, uint8_t value, uint16_t result) {
+    *flags = flags8080_table[result & 0x1ff];
+    flags->ac = (~(a ^ value ^ result) >> 4) & 1;
+}
+
+// ana sets ac from bit 3 of the operands
+static inline void flags8080_and(struct flags_8080 *flags, uint8_t a, uint8_t value, uint8_t result) {
+    *flags = flags8080_table[result];
+    flags->ac = ((a | value) >> 3) & 1;
+}
+
+// xra, ora clear both carries
+static inline void flags8080_logic(struct flags_8080 *flags, uint8_t result) {
+    *flags = flags8080_table[result];
+}
+
+// inr, dcr leave cy alone
+static inline void flags8080_inr(struct flags_8080 *flags, uint8_t result) {
+    uint8_t cy = flags->cy;
+    *flags = flags8080_table[result];
+    flags->cy = cy;
+    flags->ac = (result & 0xf) == 0;
+}
+
+static inline void flags8080_dcr(struct flags_8080 *flags, uint8_t result) {
+    uint8_t cy = flags->cy;
+    *flags = flags8080_table[result];
+    flags->cy = cy;
+    flags->ac = (result & 0xf) != 0xf;
+}
+
+// lazy flags: instead of deriving the flags after every alu op, LAZY_FLAGS builds record the
+// last operation and only derive them when something reads them (conditionals, PUSH PSW, print_state)
+enum flags8080_op {
+    FLAGS8080_NONE = 0,
+    FLAGS8080_ADD,
+    FLAGS8080_SUB,
+    FLAGS8080_AND,
+    FLAGS8080_LOGIC,
+    FLAGS8080_INR,
+    FLAGS8080_DCR,
+};
+
+struct lazy_flags_8080 {
+    uint8_t op;
+    uint8_t a;
+    uint8_t value;
+    uint16_t result; // bit 8 is the carry for every op, inr/dcr store the carry they keep there
+};
+
+static inline void flags8080_defer(struct lazy_flags_8080 *lazy, uint8_t op, uint8_t a, uint8_t value, uint16_t result) {
+    lazy->op = op;
+    lazy->a = a;
+    lazy->value = value;
+    lazy->result = result;
+}
+
+// z, s, p and cy only depend on the result so reading them never has to resolve, ac is not valid here
+static inline struct flags_8080 flags8080_peek(struct flags_8080 *flags, struct lazy_flags_8080 *lazy) {
+    if (lazy->op == FLAGS8080_NONE) return *flags;
+    return flags8080_table[lazy->result & 0x1ff];
+}
+
+static inline struct flags_8080 *flags8080_resolve(struct flags_8080 *flags, struct lazy_flags_8080 *lazy) {
+    uint8_t a = lazy->a, value = lazy->value, result = lazy->result;
+
+    if (lazy->op == FLAGS8080_NONE) return flags;
+
+    *flags = flags8080_table[lazy->result & 0x1ff];
+    switch (lazy->op) {
+        case FLAGS8080_ADD:
+            flags->ac = ((a ^ value ^ result) >> 4) & 1;
+            break;
+        case FLAGS8080_SUB:
+            flags->ac = (~(a ^ value ^ result) >> 4) & 1;
+            break;
+        case FLAGS8080_AND:
+            flags->ac = ((a | value) >> 3) & 1;
+            break;
+        case FLAGS8080_INR:
+            flags->ac = (result & 0xf) == 0;
+            break;
+        case FLAGS8080_DCR:
+            flags->ac = (result & 0xf) != 0xf;
+            break;
+    }
+    lazy->op = FLAGS8080_NONE;
+    return flags;
+}
+
+// everything outside this header goes through these so both builds share the call sites.
+// FLAGS(state) is an lvalue with every flag valid, writing through it drops the pending op.
+// FLAGS_READ(state) is an rvalue for z, s, p and cy only, which is all the conditionals need
+#ifdef LAZY_FLAGS
+#define FLAGS(state) (*flags8080_resolve(&(state)->flags, &(state)->lazy))
+#define FLAGS_READ(state) flags8080_peek(&(state)->flags, &(state)->lazy)
+#define FLAGS_ADD(state, a, value, result) flags8080_defer(&(state)->lazy, FLAGS8080_ADD, (a), (value), (result))
+#define FLAGS_SUB(state, a, value, result) flags8080_defer(&(state)->lazy, FLAGS8080_SUB, (a), (value), (result))
+#define FLAGS_AND(state, a, value, result) flags8080_defer(&(state)->lazy, FLAGS8080_AND, (a), (value), (result))
+#define FLAGS_LOGIC(state, result) flags8080_defer(&(state)->lazy, FLAGS8080_LOGIC, 0, 0, (result))
+#define FLAGS_INR(state, result) flags8080_defer(&(state)->lazy, FLAGS8080_INR, 0, 0, (result) | FLAGS_READ(state).cy << 8)
+#define FLAGS_DCR(state, result) flags8080_defer(&(state)->lazy, FLAGS8080_DCR, 0, 0, (result) | FLAGS_READ(state).cy << 8)
+#else
+#define FLAGS(state) ((state)->flags)
+#define FLAGS_READ(state) ((state)->flags)
+#define FLAGS_ADD(state, a, value, result) flags8080_add(&(state)->flags, (a), (value), (result))
+#define FLAGS_SUB(state, a, value, result) flags8080_sub(&(state)->flags, (a), (value), (result))
+#define FLAGS_AND(state, a, value, result) flags8080_and(&(state)->flags, (a), (value), (result))
+#define FLAGS_LOGIC(state, result) flags8080_logic(&(state)->flags, (result))
+#define FLAGS_INR(state, result) flags8080_inr(&(state)->flags, (result))
+#define FLAGS_DCR(state, result) flags8080_dcr(&(state)->flags, (result))
+#endif
+
+#endif //EMULATOR101_FLAGS8080_H
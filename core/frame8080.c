@@ -0,0 +1,46 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame8080.h"
+
+struct frame_store_8080 *make_frame_store() {
+    struct frame_store_8080 *store = calloc(1, sizeof(struct frame_store_8080));
+
+    for (int i = 0; i < FRAME_BUFFERS; i++) {
+        // sizeof(struct frame_8080) is a multiple of the alignment, as aligned_alloc wants
+        store->buffers[i] = aligned_alloc(FRAME_ALIGNMENT, sizeof(struct frame_8080));
+        memset(store->buffers[i], 0, sizeof(struct frame_8080));
+        // nothing has been drawn yet, every tile is stale
+        memset(store->buffers[i]->stale, 0xff, sizeof(store->buffers[i]->stale));
+    }
+    store->back = 0;
+    store->front = 2;
+    atomic_init(&store->ready, 1);
+    return store;
+}
+
+void free_frame_store(struct frame_store_8080 *store) {
+    for (int i = 0; i < FRAME_BUFFERS; i++) {
+        free(store->buffers[i]);
+    }
+    free(store);
+}
+
+struct frame_8080 *frame8080_back(struct frame_store_8080 *store) {
+    return store->buffers[store->back];
+}
+
+// release makes the pixels visible before the index, acquire on the other side pairs with it
+void frame8080_publish(struct frame_store_8080 *store) {
+    store->buffers[store->back]->number = ++store->frames;
+    int ready = atomic_exchange_explicit(&store->ready, store->back | FRAME_FRESH, memory_order_acq_rel);
+    store->back = ready & ~FRAME_FRESH;
+}
+
+const struct frame_8080 *frame8080_acquire(struct frame_store_8080 *store) {
+    if (atomic_load_explicit(&store->ready, memory_order_relaxed) & FRAME_FRESH) {
+        int ready = atomic_exchange_explicit(&store->ready, store->front, memory_order_acq_rel);
+        store->front = ready & ~FRAME_FRESH;
+    }
+    return store->buffers[store->front];
+}
@@ -0,0 +1,42 @@
+#ifndef EMULATOR101_FRAME8080_H
+#define EMULATOR101_FRAME8080_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "constants.h"
+
+#define FRAME_BUFFERS 3
+#define FRAME_ALIGNMENT 64
+
+struct frame_8080 {
+    _Alignas(FRAME_ALIGNMENT) uint8_t pixels[SCREEN_HEIGHT][SCREEN_WIDTH][4]; // rgba, already rotated upright
+    uint32_t stale[SCREEN_WIDTH / 8]; // tiles changed in vram since this buffer was last drawn
+    uint64_t number;
+};
+
+// set in ready while it holds a frame the frontend has not taken yet
+#define FRAME_FRESH 0x4
+
+// lock-free triple buffer between the video path and the frontend, which may run on different threads.
+// gpu_update draws into back and publishes it as ready, the frontend takes ready as front.
+// each side swaps its own buffer with ready in a single atomic exchange, so neither ever waits
+// for the other and a frame that is not taken in time gets replaced
+struct frame_store_8080 {
+    struct frame_8080 *buffers[FRAME_BUFFERS];
+    int back; // only touched by the producer
+    int front; // only touched by the consumer
+    atomic_int ready; // buffer index | FRAME_FRESH
+    uint64_t frames;
+};
+
+struct frame_store_8080 *make_frame_store();
+void free_frame_store(struct frame_store_8080 *store);
+
+struct frame_8080 *frame8080_back(struct frame_store_8080 *store);
+void frame8080_publish(struct frame_store_8080 *store);
+
+// newest complete frame, stays valid until the next acquire
+const struct frame_8080 *frame8080_acquire(struct frame_store_8080 *store);
+
+#endif //EMULATOR101_FRAME8080_H
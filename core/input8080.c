@@ -0,0 +1,41 @@
+#include <stdlib.h>
+
+#include "input8080.h"
+#include "core8080.h"
+#include "io8080.h"
+
+struct input_queue_8080 *make_input_queue() {
+    struct input_queue_8080 *queue = calloc(1, sizeof(struct input_queue_8080));
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    return queue;
+}
+
+int input8080_push(struct input_queue_8080 *queue, struct input_event_8080 event) {
+    unsigned tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    if (tail - head == INPUT_QUEUE_SIZE) return 0;
+    queue->events[tail % INPUT_QUEUE_SIZE] = event;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+int input8080_apply(struct input_queue_8080 *queue, struct state_8080 *state) {
+    unsigned head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    uint8_t changed[256] = {0};
+    int applied = 0;
+
+    for (; head != tail; head++, applied++) {
+        struct input_event_8080 *event = &queue->events[head % INPUT_QUEUE_SIZE];
+        if (changed[event->port] & event->mask) break;
+        changed[event->port] |= event->mask;
+
+        uint8_t value = io8080_read_port(state->io, event->port) & ~event->mask;
+        if (event->pressed) value |= event->mask;
+        io8080_write_port(state->io, event->port, value);
+    }
+    atomic_store_explicit(&queue->head, head, memory_order_release);
+    return applied;
+}
@@ -0,0 +1,36 @@
+#ifndef EMULATOR101_INPUT8080_H
+#define EMULATOR101_INPUT8080_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define INPUT_QUEUE_SIZE 64 // power of two
+
+struct state_8080;
+
+// sets (pressed) or clears the mask bits of an input port
+struct input_event_8080 {
+    uint8_t port;
+    uint8_t mask;
+    uint8_t pressed;
+};
+
+// single producer single consumer ring carrying input from the frontend to the emulation thread.
+// head is only written by the consumer, tail only by the producer
+struct input_queue_8080 {
+    struct input_event_8080 events[INPUT_QUEUE_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+};
+
+struct input_queue_8080 *make_input_queue();
+
+// returns 0 and drops the event when the queue is full
+int input8080_push(struct input_queue_8080 *queue, struct input_event_8080 event);
+
+// applies the queued events to the input ports of state. stops early at an event for bits an
+// earlier event already changed, so a press and release queued together span two frames and
+// the game still sees the press
+int input8080_apply(struct input_queue_8080 *queue, struct state_8080 *state);
+
+#endif //EMULATOR101_INPUT8080_H
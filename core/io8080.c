@@ -12,8 +12,27 @@ uint8_t io8080_read_port(struct io_8080 *io, int port) {
     return io->ports[port];
 }
 
+void io8080_attach(struct io_8080 *io, int port, uint8_t (* read) (void *context, int port),
+                   void (* write) (void *context, int port, uint8_t value), void *context) {
+    io->devices[port].read = read;
+    io->devices[port].write = write;
+    io->devices[port].context = context;
+}
+
 struct io_8080 *make_io(size_t size) {
-    struct io_8080 *io = malloc(sizeof(struct io_8080));
-    io->ports = calloc(size, sizeof(uint8_t));
+    struct io_8080 *io = calloc(1, sizeof(struct io_8080));
+    if (io == NULL) return NULL;
+
+    // every port has a latch, whatever size asks for
+    io->ports = calloc(size > IO_PORTS ? size : IO_PORTS, sizeof(uint8_t));
+    if (io->ports == NULL) {
+        free(io);
+        return NULL;
+    }
     return io;
-}
\ No newline at end of file
+}
+
+void free_io(struct io_8080 *io) {
+    free(io->ports);
+    free(io);
+}
@@ -4,15 +4,45 @@
 
 #include "constants.h"
 
-struct io_8080 {
-    uint8_t *ports;
+#define IO_PORTS 256
+
+struct io_8080;
 
-    void (* notify_read) (int port);
-    void (* notify_write) (int port);
+// a device behind one port. either handler may be NULL, IN then returns the byte last
+// latched into ports and OUT latches its byte there without calling anything
+struct port_8080 {
+    uint8_t (* read) (void *context, int port);
+    void (* write) (void *context, int port, uint8_t value);
+    void *context;
+};
+
+struct io_8080 {
+    uint8_t *ports; // latched bytes, inputs are written here from outside the cpu
+    struct port_8080 devices[IO_PORTS];
 };
 
+// the outside world setting what a port reads, an input for example. never calls a device
 void io8080_write_port(struct io_8080 *io, int port, uint8_t value);
 
 uint8_t io8080_read_port(struct io_8080 *io, int port);
 
-struct io_8080 *make_io(size_t size);
\ No newline at end of file
+// the cpu's IN and OUT, through the port's device when it has one
+static inline uint8_t io8080_in(struct io_8080 *io, int port) {
+    struct port_8080 *device = &io->devices[port];
+    return device->read ? device->read(device->context, port) : io->ports[port];
+}
+
+static inline void io8080_out(struct io_8080 *io, int port, uint8_t value) {
+    struct port_8080 *device = &io->devices[port];
+    if (device->write) device->write(device->context, port, value);
+    else io->ports[port] = value;
+}
+
+// for device modules, replaces whatever was on port
+void io8080_attach(struct io_8080 *io, int port, uint8_t (* read) (void *context, int port),
+                   void (* write) (void *context, int port, uint8_t value), void *context);
+
+// NULL when the host refuses the memory
+struct io_8080 *make_io(size_t size);
+
+void free_io(struct io_8080 *io);
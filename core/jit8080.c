@@ -0,0 +1,825 @@
+#define _GNU_SOURCE // memfd_create
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "jit8080.h"
+#include "core8080.h"
+#include "cycles8080.h"
+#include "constants.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#include <cpuid.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// the cache keeps at least this much room before a block is translated, a block of
+// JIT_MAX_BLOCK pushes stays well below it
+#define JIT_BLOCK_BYTES 8192
+
+#define PAGE_SLOW 0x1 // writes go through memory8080_write: vram, read only pages and mirrors
+#define PAGE_CODE 0x2 // some block was translated from this page, writes may invalidate it
+
+struct jit_8080 {
+    // host code per 8080 pc, exit for pcs without a block. first so the blocks can jump
+    // through it with a 32 bit displacement
+    void *entry[0x10000];
+    uint8_t length[0x10000]; // 8080 bytes the block at each pc was translated from
+    uint8_t page[256];
+    uint32_t map_version; // of the state's page table PAGE_SLOW was taken from
+
+    // flags as lahf and sahf keep them in ah, which is the 8080's own layout, to and from
+    // the layout pack_flags gives PUSH PSW
+    uint8_t to_psw[256];
+    uint8_t from_psw[256];
+
+    // shared with the translated code
+    uint8_t invalidated; // a write dropped a block, the running one leaves after the instruction
+    uint8_t flags;
+    int64_t count_left;
+    int64_t cycles_left;
+
+    // one memfd mapped twice, so the cache is never writable and executable at once. the
+    // emitter writes through writable, blocks run from code
+    uint8_t *code;
+    uint8_t *writable;
+    size_t used;
+    size_t stubs; // bytes of enter, exit and write at the start of code
+    void (*enter)(struct state_8080 *state, struct jit_8080 *jit);
+    uint8_t *exit;
+    uint8_t *write;
+};
+
+// host registers. while translated code runs a and the flags are al and ah, bc, de and hl are
+// bx, cx and dx so memory[hl] is [rsi + rdx], and sp is bp. rax..rdx stay below 0x10000.
+// rsi is memory, rdi the state, r12 the jit, r13 the 8080 pc, r14 and r15 the instructions and
+// cycles left. r8..r11 are scratch
+enum {
+    NONE = -1,
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+// byte registers. ah..bh only exist without a REX prefix, so they never share an
+// instruction with r8..r15
+enum {
+    AL = 0, CL, DL, BL, AH, CH, DH, BH,
+};
+
+// 8080 register numbers as opcodes encode them: b c d e h l m a
+enum { REG_B, REG_C, REG_D, REG_E, REG_H, REG_L, REG_M, REG_A };
+
+static const int host_byte[8] = {BH, BL, CH, CL, DH, DL, NONE, AL};
+static const int host_pair[4] = {RBX, RCX, RDX, RBP}; // bc de hl sp
+
+// x86 alu opcodes in 8080 order: add adc sub sbb ana xra ora cmp. op r/m8, r8 form,
+// +2 is op r8, r/m8 and +4 op al, imm8
+static const uint8_t alu_opcode[8] = {0x00, 0x10, 0x28, 0x18, 0x20, 0x30, 0x08, 0x38};
+
+// lahf bits of the conditions in 8080 order: nz z nc c po pe p m
+static const uint8_t condition_mask[8] = {0x40, 0x40, 0x01, 0x01, 0x04, 0x04, 0x80, 0x80};
+
+struct emitter {
+    uint8_t *code; // writable view
+    uint8_t *runs; // where code runs from, for displacements and entry points
+    size_t used;
+};
+
+static void put8(struct emitter *e, uint8_t value) {
+    e->code[e->used++] = value;
+}
+
+static void put32(struct emitter *e, uint32_t value) {
+    memcpy(&e->code[e->used], &value, 4);
+    e->used += 4;
+}
+
+static void put64(struct emitter *e, uint64_t value) {
+    memcpy(&e->code[e->used], &value, 8);
+    e->used += 8;
+}
+
+// 0x66 and REX for an operand size of 8, 16, 32 or 64 bits
+static void prefix(struct emitter *e, int size, int reg, int rm, int index) {
+    uint8_t rex = (size == 64) << 3 | (reg >= R8) << 2 | (index >= R8) << 1 | (rm >= R8);
+
+    if (size == 16) put8(e, 0x66);
+    if (rex) put8(e, 0x40 | rex);
+}
+
+// opcodes above 0xff are two bytes, 0x0fb6 is 0f b6
+static void opcode(struct emitter *e, int op) {
+    if (op > 0xff) put8(e, op >> 8);
+    put8(e, op & 0xff);
+}
+
+// reg is a register or the /digit of the opcode
+static void op_rr(struct emitter *e, int size, int op, int reg, int rm) {
+    prefix(e, size, reg, rm, NONE);
+    opcode(e, op);
+    put8(e, 0xc0 | (reg & 7) << 3 | (rm & 7));
+}
+
+// [base + index << scale + disp]
+static void op_rm(struct emitter *e, int size, int op, int reg, int base, int index, int scale, int32_t disp) {
+    int mod = disp == 0 && (base & 7) != RBP ? 0 : disp >= -128 && disp < 128 ? 1 : 2;
+
+    prefix(e, size, reg, base, index);
+    opcode(e, op);
+    if (index == NONE && (base & 7) != RSP) {
+        put8(e, mod << 6 | (reg & 7) << 3 | (base & 7));
+    } else {
+        put8(e, mod << 6 | (reg & 7) << 3 | 4);
+        put8(e, scale << 6 | (index == NONE ? 4 : index & 7) << 3 | (base & 7));
+    }
+    if (mod == 1) put8(e, disp);
+    if (mod == 2) put32(e, disp);
+}
+
+static void mov_imm(struct emitter *e, int reg, uint32_t value) {
+    prefix(e, 32, NONE, reg, NONE);
+    put8(e, 0xb8 + (reg & 7));
+    put32(e, value);
+}
+
+// a jump or jcc with its target left open, returns where bind patches it
+static size_t jump(struct emitter *e, int op) {
+    opcode(e, op);
+    put32(e, 0);
+    return e->used - 4;
+}
+
+static void bind(struct emitter *e, size_t at) {
+    int32_t distance = e->used - (at + 4);
+    memcpy(&e->code[at], &distance, 4);
+}
+
+static void jump_to(struct emitter *e, int op, const uint8_t *target) {
+    opcode(e, op);
+    put32(e, target - (e->runs + e->used + 4));
+}
+
+// value of an 8080 register, zero extended into a 32 bit scratch
+static void load_byte(struct emitter *e, int dst, int reg) {
+    int host = host_byte[reg];
+
+    if (host >= AH) {
+        op_rr(e, 32, 0x89, host - AH, dst); // mov dst, e?x
+        op_rr(e, 32, 0xc1, 5, dst); // shr dst, 8
+        put8(e, 8);
+    } else {
+        op_rr(e, 32, 0x0fb6, dst, host); // movzx dst, ?l
+    }
+}
+
+// memory[r8d] = r9b. pages that need more than a store go through memory8080_write
+static void write_byte(struct jit_8080 *jit, struct emitter *e) {
+    op_rr(e, 32, 0x89, R8, R10); // mov r10d, r8d
+    op_rr(e, 32, 0xc1, 5, R10); // shr r10d, 8
+    put8(e, 8);
+    op_rm(e, 8, 0xf6, 0, R12, R10, 0, offsetof(struct jit_8080, page)); // test [r12 + r10 + page]
+    put8(e, PAGE_SLOW | PAGE_CODE);
+    size_t slow = jump(e, 0x0f85);
+    op_rm(e, 8, 0x88, R9, RSI, R8, 0, 0); // mov [rsi + r8], r9b
+    size_t done = jump(e, 0xe9);
+    bind(e, slow);
+    jump_to(e, 0xe8, jit->write);
+    bind(e, done);
+}
+
+// r8d = (sp + offset) & 0xffff
+static void stack_address(struct emitter *e, int offset) {
+    op_rm(e, 32, 0x8d, R8, RBP, NONE, 0, offset); // lea r8d, [rbp + offset]
+    op_rr(e, 32, 0x0fb7, R8, R8); // movzx r8d, r8w
+}
+
+static void push_word(struct jit_8080 *jit, struct emitter *e, uint16_t value) {
+    stack_address(e, -1);
+    mov_imm(e, R9, value >> 8);
+    write_byte(jit, e);
+    stack_address(e, -2);
+    mov_imm(e, R9, value & 0xff);
+    write_byte(jit, e);
+    op_rr(e, 16, 0x83, 5, RBP); // sub bp, 2
+    put8(e, 2);
+}
+
+// mov byte [rsi + rbp], then inc bp
+static void pop_byte(struct emitter *e, int op, int reg) {
+    op_rm(e, op == 0x8a ? 8 : 32, op, reg, RSI, RBP, 0, 0);
+    op_rr(e, 16, 0xff, 0, RBP);
+}
+
+// copies the carry lahf would see into the flags in ah, leaving the others alone
+static void carry_to_flags(struct emitter *e) {
+    op_rr(e, 8, 0xd0, 3, AH); // rcr ah, 1
+    op_rr(e, 8, 0xd0, 0, AH); // rol ah, 1
+}
+
+static void sub_imm(struct emitter *e, int reg, uint32_t value) {
+    op_rr(e, 64, 0x81, 5, reg);
+    put32(e, value);
+}
+
+// takes the instructions and cycles of the block off the budget
+static void account(struct emitter *e, uint32_t cycles, int count) {
+    sub_imm(e, R15, cycles);
+    sub_imm(e, R14, count);
+}
+
+// continues at pc, through the entry table so blocks dropped since stay dropped
+static void chain(struct emitter *e, uint16_t pc) {
+    mov_imm(e, R13, pc);
+    op_rm(e, 32, 0xff, 4, R12, NONE, 0, pc * 8); // jmp [r12 + pc * 8]
+}
+
+static void chain_r13(struct emitter *e) {
+    op_rm(e, 32, 0xff, 4, R12, R13, 3, 0); // jmp [r12 + r13 * 8]
+}
+
+static void ret(struct emitter *e) {
+    pop_byte(e, 0x0fb6, R13);
+    pop_byte(e, 0x0fb6, R8);
+    op_rr(e, 32, 0xc1, 4, R8); // shl r8d, 8
+    put8(e, 8);
+    op_rr(e, 32, 0x09, R8, R13); // or r13d, r8d
+    chain_r13(e);
+}
+
+// jumps to taken when condition cc of the opcode holds, falls through otherwise
+static size_t condition(struct emitter *e, uint8_t op) {
+    int cc = (op >> 3) & 7;
+
+    op_rr(e, 8, 0xf6, 0, AH); // test ah, mask
+    put8(e, condition_mask[cc]);
+    return jump(e, cc & 1 ? 0x0f85 : 0x0f84);
+}
+
+// the operand of ana (a register, m or the immediate) into r9d
+static void alu_operand(struct emitter *e, int source, uint8_t immediate) {
+    if (source == REG_M) op_rm(e, 32, 0x0fb6, R9, RSI, RDX, 0, 0);
+    else if (source < 0) mov_imm(e, R9, immediate);
+    else load_byte(e, R9, source);
+}
+
+// source is an 8080 register, REG_M, or -1 for the immediate
+static void alu(struct emitter *e, int operation, int source, uint8_t immediate) {
+    uint8_t op = alu_opcode[operation];
+
+    if (operation == 4) {
+        // ana sets ac from bit 3 of the operands, the x86 and leaves it undefined
+        alu_operand(e, source, immediate);
+        op_rr(e, 32, 0x89, RAX, R8); // mov r8d, eax
+        op_rr(e, 32, 0x09, R9, R8); // or r8d, r9d
+        op_rr(e, 32, 0x83, 4, R8); // and r8d, 8
+        put8(e, 8);
+        op_rr(e, 32, 0xc1, 4, R8); // shl r8d, 9
+        put8(e, 9);
+        op_rr(e, 8, 0x20, R9, AL); // and al, r9b
+        put8(e, 0x9f); // lahf
+        op_rr(e, 8, 0x80, 4, AH); // and ah, ~ac
+        put8(e, 0xef);
+        op_rr(e, 32, 0x09, R8, RAX); // or eax, r8d
+        return;
+    }
+
+    if (operation == 1 || operation == 3) put8(e, 0x9e); // sahf, carry in
+    if (source == REG_M) {
+        op_rm(e, 8, op + 2, AL, RSI, RDX, 0, 0);
+    } else if (source < 0) {
+        put8(e, op + 4);
+        put8(e, immediate);
+    } else {
+        op_rr(e, 8, op, host_byte[source], AL);
+    }
+    put8(e, 0x9f); // lahf
+
+    // x86 ac is the half borrow on subtraction, the 8080 keeps the half carry of the complement
+    if (operation == 2 || operation == 3 || operation == 7) {
+        op_rr(e, 8, 0x80, 6, AH); // xor ah, ac
+        put8(e, 0x10);
+    }
+    if (operation == 5 || operation == 6) {
+        op_rr(e, 8, 0x80, 4, AH); // and ah, ~ac
+        put8(e, 0xef);
+    }
+}
+
+static int instruction_length(uint8_t op) {
+    if ((op & 0xc7) == 0x06 || (op & 0xc7) == 0xc6 || op == 0xd3 || op == 0xdb) return 2;
+    if ((op & 0xcf) == 0x01 || (op & 0xc7) == 0xc2 || (op & 0xc7) == 0xc4) return 3;
+    if (op == 0x22 || op == 0x2a || op == 0x32 || op == 0x3a) return 3;
+    if (op == 0xc3 || op == 0xcb || op == 0xcd || op == 0xdd || op == 0xed || op == 0xfd) return 3;
+    return 1;
+}
+
+// left to cpu_update: DAA, HLT, OUT, IN, XTHL
+static int translatable(uint8_t op) {
+    return op != 0x27 && op != 0x76 && op != 0xd3 && op != 0xdb && op != 0xe3;
+}
+
+// jumps, calls, returns, rst and pchl, the last instruction of a block
+static int ends_block(uint8_t op) {
+    if ((op & 0xc0) != 0xc0) return 0;
+    if ((op & 0x07) == 0x00 || (op & 0x07) == 0x02 || (op & 0x07) == 0x04 || (op & 0x07) == 0x07) return 1;
+    return op == 0xc3 || op == 0xc9 || op == 0xcb || op == 0xcd || op == 0xd9 ||
+           op == 0xdd || op == 0xe9 || op == 0xed || op == 0xfd;
+}
+
+// emits an instruction that does not end the block. returns 1 when it may write memory
+static int translate_instruction(struct jit_8080 *jit, struct emitter *e, uint8_t *code) {
+    uint8_t op = code[0];
+    uint16_t word = code[2] << 8 | code[1];
+    int dst = (op >> 3) & 7, src = op & 7, pair = (op >> 4) & 3;
+
+    if (op >= 0x40 && op < 0x80) { // MOV
+        if (dst == REG_M) {
+            load_byte(e, R9, src);
+            op_rr(e, 32, 0x89, RDX, R8); // mov r8d, edx
+            write_byte(jit, e);
+            return 1;
+        }
+        if (src == REG_M) op_rm(e, 8, 0x8a, host_byte[dst], RSI, RDX, 0, 0);
+        else if (src != dst) op_rr(e, 8, 0x88, host_byte[src], host_byte[dst]);
+        return 0;
+    }
+    if (op >= 0x80 && op < 0xc0) { // ADD ... CMP
+        alu(e, dst, src, 0);
+        return 0;
+    }
+    if ((op & 0xc7) == 0xc6) { // ADI ... CPI
+        alu(e, dst, -1, code[1]);
+        return 0;
+    }
+    if ((op & 0xc7) == 0x04 || (op & 0xc7) == 0x05) { // INR, DCR
+        int digit = op & 1;
+
+        put8(e, 0x9e); // sahf, both keep the carry
+        if (dst == REG_M) {
+            op_rm(e, 32, 0x0fb6, R9, RSI, RDX, 0, 0); // movzx r9d, [rsi + rdx]
+            op_rr(e, 8, 0xfe, digit, R9);
+        } else {
+            op_rr(e, 8, 0xfe, digit, host_byte[dst]);
+        }
+        put8(e, 0x9f); // lahf
+        if (digit) {
+            op_rr(e, 8, 0x80, 6, AH); // xor ah, ac
+            put8(e, 0x10);
+        }
+        if (dst != REG_M) return 0;
+        op_rr(e, 32, 0x89, RDX, R8);
+        write_byte(jit, e);
+        return 1;
+    }
+    if ((op & 0xc7) == 0x06) { // MVI
+        if (dst != REG_M) {
+            put8(e, 0xb0 + host_byte[dst]);
+            put8(e, code[1]);
+            return 0;
+        }
+        mov_imm(e, R9, code[1]);
+        op_rr(e, 32, 0x89, RDX, R8);
+        write_byte(jit, e);
+        return 1;
+    }
+    if ((op & 0xcf) == 0x01) { // LXI
+        mov_imm(e, host_pair[pair], word);
+        return 0;
+    }
+    if ((op & 0xcf) == 0x03 || (op & 0xcf) == 0x0b) { // INX, DCX
+        op_rr(e, 16, 0xff, (op >> 3) & 1, host_pair[pair]);
+        return 0;
+    }
+    if ((op & 0xcf) == 0x09) { // DAD
+        op_rr(e, 16, 0x01, host_pair[pair], RDX); // add dx, rp
+        carry_to_flags(e);
+        return 0;
+    }
+    if ((op & 0xcb) == 0xc1) { // POP, PUSH
+        int push = op & 4;
+
+        if (push) {
+            // psw pushes a, then the flags as pack_flags lays them out
+            stack_address(e, -1);
+            load_byte(e, R9, pair == 3 ? REG_A : pair * 2);
+            write_byte(jit, e);
+            stack_address(e, -2);
+            if (pair == 3) {
+                op_rr(e, 32, 0x89, RAX, R9); // mov r9d, eax
+                op_rr(e, 32, 0xc1, 5, R9); // shr r9d, 8
+                put8(e, 8);
+                op_rm(e, 32, 0x0fb6, R9, R12, R9, 0, offsetof(struct jit_8080, to_psw));
+            } else {
+                load_byte(e, R9, pair * 2 + 1);
+            }
+            write_byte(jit, e);
+            op_rr(e, 16, 0x83, 5, RBP); // sub bp, 2
+            put8(e, 2);
+            return 1;
+        }
+        if (pair == 3) {
+            pop_byte(e, 0x0fb6, R8);
+            op_rm(e, 32, 0x0fb6, R8, R12, R8, 0, offsetof(struct jit_8080, from_psw));
+            pop_byte(e, 0x8a, AL);
+            op_rr(e, 32, 0x0fb6, RAX, AL); // movzx eax, al
+            op_rr(e, 32, 0xc1, 4, R8); // shl r8d, 8
+            put8(e, 8);
+            op_rr(e, 32, 0x09, R8, RAX); // or eax, r8d
+            return 0;
+        }
+        pop_byte(e, 0x8a, host_byte[pair * 2 + 1]);
+        pop_byte(e, 0x8a, host_byte[pair * 2]);
+        return 0;
+    }
+
+    switch (op) {
+        case 0x02: // STAX B
+        case 0x12: // STAX D
+            op_rr(e, 32, 0x0fb6, R9, AL);
+            op_rr(e, 32, 0x89, host_pair[pair], R8);
+            write_byte(jit, e);
+            return 1;
+        case 0x0a: // LDAX B
+        case 0x1a: // LDAX D
+            op_rm(e, 8, 0x8a, AL, RSI, host_pair[pair], 0, 0);
+            return 0;
+        case 0x22: // SHLD adr
+            mov_imm(e, R8, word);
+            load_byte(e, R9, REG_L);
+            write_byte(jit, e);
+            mov_imm(e, R8, (uint16_t) (word + 1));
+            load_byte(e, R9, REG_H);
+            write_byte(jit, e);
+            return 1;
+        case 0x2a: // LHLD adr
+            op_rm(e, 8, 0x8a, DL, RSI, NONE, 0, word);
+            op_rm(e, 8, 0x8a, DH, RSI, NONE, 0, (uint16_t) (word + 1));
+            return 0;
+        case 0x32: // STA adr
+            mov_imm(e, R8, word);
+            op_rr(e, 32, 0x0fb6, R9, AL);
+            write_byte(jit, e);
+            return 1;
+        case 0x3a: // LDA adr
+            op_rm(e, 8, 0x8a, AL, RSI, NONE, 0, word);
+            return 0;
+        case 0x07: // RLC
+            op_rr(e, 8, 0xd0, 0, AL);
+            carry_to_flags(e);
+            return 0;
+        case 0x0f: // RRC
+            op_rr(e, 8, 0xd0, 1, AL);
+            carry_to_flags(e);
+            return 0;
+        case 0x17: // RAL
+            put8(e, 0x9e);
+            op_rr(e, 8, 0xd0, 2, AL);
+            carry_to_flags(e);
+            return 0;
+        case 0x1f: // RAR
+            put8(e, 0x9e);
+            op_rr(e, 8, 0xd0, 3, AL);
+            carry_to_flags(e);
+            return 0;
+        case 0x2f: // CMA
+            op_rr(e, 8, 0xf6, 2, AL);
+            return 0;
+        case 0x37: // STC
+            op_rr(e, 8, 0x80, 1, AH);
+            put8(e, 0x01);
+            return 0;
+        case 0x3f: // CMC
+            op_rr(e, 8, 0x80, 6, AH);
+            put8(e, 0x01);
+            return 0;
+        case 0xeb: // XCHG
+            op_rr(e, 16, 0x87, RCX, RDX);
+            return 0;
+        case 0xf9: // SPHL
+            op_rr(e, 32, 0x89, RDX, RBP);
+            return 0;
+        case 0xf3: // DI
+        case 0xfb: // EI
+            op_rm(e, 8, 0xc6, 0, RDI, NONE, 0, offsetof(struct state_8080, int_enable));
+            put8(e, op == 0xfb);
+            return 0;
+    }
+    return 0; // NOPs
+}
+
+// a block runs whole or not at all: it only starts when the interpreter would still have
+// executed its last instruction, so the budget ends on the same instruction either way
+static void *translate(struct jit_8080 *jit, struct state_8080 *state) {
+    uint16_t start = state->pc;
+    uint8_t *memory = state->memory;
+    uint32_t before[JIT_MAX_BLOCK + 1]; // cycles ahead of each instruction
+    uint16_t pcs[JIT_MAX_BLOCK + 1];
+    int n = 0;
+    uint32_t pc = start;
+
+    while (n < JIT_MAX_BLOCK && pc < 0x10000 && translatable(memory[pc])) {
+        uint8_t op = memory[pc];
+
+        if (pc + instruction_length(op) > 0x10000) break;
+        before[n + 1] = (n ? before[n] : 0) + cycles_8080[op];
+        pcs[n++] = pc;
+        pc += instruction_length(op);
+        if (ends_block(op)) break;
+    }
+    if (n == 0) return NULL;
+    before[0] = 0;
+    pcs[n] = pc;
+
+    if (JIT_CACHE_SIZE - jit->used < JIT_BLOCK_BYTES) {
+        for (int i = 0; i < 0x10000; i++) jit->entry[i] = jit->exit;
+        for (int i = 0; i < 256; i++) jit->page[i] &= ~PAGE_CODE;
+        jit->used = jit->stubs;
+    }
+
+    struct emitter e = {jit->writable, jit->code, jit->used};
+    void *block = e.runs + e.used;
+
+    op_rr(&e, 64, 0x81, 7, R15); // cmp r15, cycles ahead of the last instruction
+    put32(&e, before[n - 1]);
+    jump_to(&e, 0x0f8e, jit->exit); // jle
+    op_rr(&e, 64, 0x81, 7, R14); // cmp r14, instructions
+    put32(&e, n);
+    jump_to(&e, 0x0f8c, jit->exit); // jl
+
+    for (int i = 0; i < n; i++) {
+        uint8_t *code = &memory[pcs[i]];
+        uint8_t op = code[0];
+        uint16_t target = code[2] << 8 | code[1];
+
+        if (!ends_block(op)) {
+            if (!translate_instruction(jit, &e, code)) continue;
+
+            // the write went over translated code, leave before running stale instructions
+            op_rm(&e, 8, 0x80, 7, R12, NONE, 0, offsetof(struct jit_8080, invalidated));
+            put8(&e, 0);
+            size_t intact = jump(&e, 0x0f84);
+            account(&e, before[i + 1], i + 1);
+            mov_imm(&e, R13, pcs[i + 1]);
+            jump_to(&e, 0xe9, jit->exit);
+            bind(&e, intact);
+            continue;
+        }
+
+        account(&e, before[n], n);
+        if (op == 0xc3 || op == 0xcb) { // JMP
+            chain(&e, target);
+        } else if ((op & 0xc7) == 0xc2) { // Jcc
+            size_t taken = condition(&e, op);
+            chain(&e, pcs[i] + 3);
+            bind(&e, taken);
+            chain(&e, target);
+        } else if (op == 0xcd || op == 0xdd || op == 0xed || op == 0xfd) { // CALL
+            push_word(jit, &e, pcs[i] + 3);
+            chain(&e, target);
+        } else if ((op & 0xc7) == 0xc4) { // Ccc
+            size_t taken = condition(&e, op);
+            chain(&e, pcs[i] + 3);
+            bind(&e, taken);
+            sub_imm(&e, R15, CYCLES_8080_TAKEN);
+            push_word(jit, &e, pcs[i] + 3);
+            chain(&e, target);
+        } else if (op == 0xc9 || op == 0xd9) { // RET
+            ret(&e);
+        } else if ((op & 0xc7) == 0xc0) { // Rcc
+            size_t taken = condition(&e, op);
+            chain(&e, pcs[i] + 1);
+            bind(&e, taken);
+            sub_imm(&e, R15, CYCLES_8080_TAKEN);
+            ret(&e);
+        } else if ((op & 0xc7) == 0xc7) { // RST
+            push_word(jit, &e, pcs[i] + 1);
+            chain(&e, op & 0x38);
+        } else { // PCHL
+            op_rr(&e, 32, 0x89, RDX, R13); // mov r13d, edx
+            chain_r13(&e);
+        }
+    }
+    if (!ends_block(memory[pcs[n - 1]])) {
+        // cut short by an instruction left to cpu_update or by the length limit
+        account(&e, before[n], n);
+        chain(&e, pcs[n]);
+    }
+
+    jit->used = e.used;
+    jit->entry[start] = block;
+    jit->length[start] = pc - start;
+    for (uint32_t page = start >> 8; page <= (pc - 1) >> 8; page++) jit->page[page] |= PAGE_CODE;
+    return block;
+}
+
+// enter(state, jit) loads the registers and jumps to the block at state->pc, exit stores them back
+// with r13 as pc. write is called from the blocks for memory[r8d] = r9b with the scratch
+// registers free and the stack aligned, and keeps every other register
+static void emit_stubs(struct jit_8080 *jit) {
+    static const int saved[] = {RBX, RBP, R12, R13, R14, R15};
+    static const struct {
+        int host;
+        size_t offset;
+    } registers[] = {
+            {AL, offsetof(struct state_8080, a)}, {BH, offsetof(struct state_8080, b)},
+            {BL, offsetof(struct state_8080, c)}, {CH, offsetof(struct state_8080, d)},
+            {CL, offsetof(struct state_8080, e)}, {DH, offsetof(struct state_8080, h)},
+            {DL, offsetof(struct state_8080, l)},
+    };
+    struct emitter e = {jit->writable, jit->code, 0};
+
+    jit->enter = (void *) e.runs;
+    for (int i = 0; i < 6; i++) {
+        prefix(&e, 32, NONE, saved[i], NONE);
+        put8(&e, 0x50 + (saved[i] & 7)); // push
+    }
+    op_rr(&e, 64, 0x83, 5, RSP); // sub rsp, 8
+    put8(&e, 8);
+    op_rr(&e, 64, 0x89, RSI, R12); // mov r12, rsi
+    op_rm(&e, 32, 0x0fb6, RAX, R12, NONE, 0, offsetof(struct jit_8080, flags));
+    op_rr(&e, 32, 0xc1, 4, RAX); // shl eax, 8
+    put8(&e, 8);
+    op_rr(&e, 32, 0x31, RBX, RBX); // xor ebx, ebx
+    op_rr(&e, 32, 0x31, RCX, RCX);
+    op_rr(&e, 32, 0x31, RDX, RDX);
+    for (int i = 0; i < 7; i++) op_rm(&e, 8, 0x8a, registers[i].host, RDI, NONE, 0, registers[i].offset);
+    op_rm(&e, 32, 0x0fb7, RBP, RDI, NONE, 0, offsetof(struct state_8080, sp));
+    op_rm(&e, 32, 0x0fb7, R13, RDI, NONE, 0, offsetof(struct state_8080, pc));
+    op_rm(&e, 64, 0x8b, R14, R12, NONE, 0, offsetof(struct jit_8080, count_left));
+    op_rm(&e, 64, 0x8b, R15, R12, NONE, 0, offsetof(struct jit_8080, cycles_left));
+    op_rm(&e, 64, 0x8b, RSI, RDI, NONE, 0, offsetof(struct state_8080, memory));
+    chain_r13(&e);
+
+    jit->exit = e.runs + e.used;
+    for (int i = 0; i < 7; i++) op_rm(&e, 8, 0x88, registers[i].host, RDI, NONE, 0, registers[i].offset);
+    op_rm(&e, 16, 0x89, RBP, RDI, NONE, 0, offsetof(struct state_8080, sp));
+    op_rm(&e, 16, 0x89, R13, RDI, NONE, 0, offsetof(struct state_8080, pc));
+    op_rr(&e, 32, 0xc1, 5, RAX); // shr eax, 8
+    put8(&e, 8);
+    op_rm(&e, 8, 0x88, AL, R12, NONE, 0, offsetof(struct jit_8080, flags));
+    op_rm(&e, 64, 0x89, R14, R12, NONE, 0, offsetof(struct jit_8080, count_left));
+    op_rm(&e, 64, 0x89, R15, R12, NONE, 0, offsetof(struct jit_8080, cycles_left));
+    op_rr(&e, 64, 0x83, 0, RSP); // add rsp, 8
+    put8(&e, 8);
+    for (int i = 5; i >= 0; i--) {
+        prefix(&e, 32, NONE, saved[i], NONE);
+        put8(&e, 0x58 + (saved[i] & 7)); // pop
+    }
+    put8(&e, 0xc3);
+
+    // the call pushed 8 bytes and the five pushes make it 48, aligned again for the call out
+    jit->write = e.runs + e.used;
+    put8(&e, 0x50); // push rax
+    put8(&e, 0x51); // push rcx
+    put8(&e, 0x52); // push rdx
+    put8(&e, 0x56); // push rsi
+    put8(&e, 0x57); // push rdi
+    op_rr(&e, 32, 0x89, R8, RSI); // mov esi, r8d
+    op_rr(&e, 32, 0x89, R9, RDX); // mov edx, r9d
+    put8(&e, 0x48); // mov rax, memory8080_write
+    put8(&e, 0xb8);
+    put64(&e, (uint64_t) (uintptr_t) memory8080_write);
+    put8(&e, 0xff); // call rax
+    put8(&e, 0xd0);
+    put8(&e, 0x5f);
+    put8(&e, 0x5e);
+    put8(&e, 0x5a);
+    put8(&e, 0x59);
+    put8(&e, 0x58);
+    put8(&e, 0xc3);
+
+    jit->stubs = jit->used = e.used;
+}
+
+struct jit_8080 *make_jit() {
+    unsigned int eax, ebx, ecx, edx;
+
+    // lahf and sahf are optional in long mode, only the very first x86-64 parts lack them
+    if (!__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) || !(ecx & 1)) return NULL;
+
+    int fd = memfd_create("emulator101-jit", MFD_CLOEXEC);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, JIT_CACHE_SIZE)) {
+        close(fd);
+        return NULL;
+    }
+    uint8_t *writable = mmap(NULL, JIT_CACHE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    uint8_t *code = mmap(NULL, JIT_CACHE_SIZE, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+    close(fd);
+
+    struct jit_8080 *jit = writable == MAP_FAILED || code == MAP_FAILED ? NULL : calloc(1, sizeof(struct jit_8080));
+    if (jit == NULL) {
+        if (writable != MAP_FAILED) munmap(writable, JIT_CACHE_SIZE);
+        if (code != MAP_FAILED) munmap(code, JIT_CACHE_SIZE);
+        return NULL;
+    }
+    jit->code = code;
+    jit->writable = writable;
+    emit_stubs(jit);
+    for (int i = 0; i < 0x10000; i++) jit->entry[i] = jit->exit;
+    for (int i = 0; i < 256; i++) {
+        jit->to_psw[i] = (i >> 6 & 1) | (i >> 7 & 1) << 1 | (i >> 2 & 1) << 2 | (i & 1) << 3 | (i >> 4 & 1) << 4;
+        jit->from_psw[i] = (i & 1) << 6 | (i >> 1 & 1) << 7 | (i >> 2 & 1) << 2 | (i >> 3 & 1) | (i >> 4 & 1) << 4 | 0x02;
+    }
+    return jit;
+}
+
+void free_jit(struct jit_8080 *jit) {
+    munmap(jit->code, JIT_CACHE_SIZE);
+    munmap(jit->writable, JIT_CACHE_SIZE);
+    free(jit);
+}
+
+void jit8080_invalidate(struct jit_8080 *jit, uint16_t offset) {
+    if (!(jit->page[offset >> 8] & PAGE_CODE)) return;
+
+    // blocks are at most JIT_MAX_BLOCK * 3 bytes long, nothing starting further back reaches offset
+    int first = offset < JIT_MAX_BLOCK * 3 ? 0 : offset - JIT_MAX_BLOCK * 3;
+    for (int pc = first; pc <= offset; pc++) {
+        if (jit->entry[pc] == jit->exit || pc + jit->length[pc] <= offset) continue;
+        jit->entry[pc] = jit->exit;
+        jit->invalidated = 1;
+    }
+}
+
+// one instruction through cpu_update, for what the blocks leave out
+static int interpret(struct jit_8080 *jit, struct state_8080 *state) {
+    uint64_t cycles = state->cycles;
+    int halted = cpu_update(state);
+
+    jit->cycles_left -= state->cycles - cycles;
+    jit->count_left -= 1;
+    return halted;
+}
+
+// a store is enough unless the state's page table says otherwise. mirrors go through
+// memory8080_write as well, it drops the code translated from every address of the byte
+static void sync_pages(struct jit_8080 *jit, struct state_8080 *state) {
+    for (int page = 0; page < 256; page++) {
+        struct page_8080 *entry = &state->pages[page];
+        int slow = (entry->flags & (MEM_SLOW | MEM_MIRROR)) || entry->next != page;
+
+        jit->page[page] = (jit->page[page] & PAGE_CODE) | (slow ? PAGE_SLOW : 0);
+    }
+    jit->map_version = state->map_version;
+}
+
+int jit8080_run(struct state_8080 *state, long n_instructions, uint64_t cycle_limit) {
+    struct jit_8080 *jit = state->jit;
+
+    if (jit->map_version != state->map_version) sync_pages(jit, state);
+    if (cycle_limit <= state->cycles) return 0;
+    jit->count_left = n_instructions;
+    jit->cycles_left = cycle_limit - state->cycles > INT64_MAX ? INT64_MAX : cycle_limit - state->cycles;
+
+    while (jit->count_left > 0 && jit->cycles_left > 0) {
+        int64_t count = jit->count_left, cycles = jit->cycles_left;
+        void *block = jit->entry[state->pc];
+
+        if (block == jit->exit) block = translate(jit, state);
+        if (block != NULL) {
+            struct flags_8080 *flags = &FLAGS(state);
+
+            jit->flags = flags->s << 7 | flags->z << 6 | flags->ac << 4 | flags->p << 2 | 0x02 | flags->cy;
+            jit->invalidated = 0;
+            jit->enter(state, jit);
+            state->cycles += cycles - jit->cycles_left;
+
+            flags = &FLAGS(state);
+            flags->s = jit->flags >> 7 & 1;
+            flags->z = jit->flags >> 6 & 1;
+            flags->ac = jit->flags >> 4 & 1;
+            flags->p = jit->flags >> 2 & 1;
+            flags->cy = jit->flags & 1;
+        }
+        // not translatable or too long for what is left of the budget
+        if (jit->count_left == count && interpret(jit, state)) return 1;
+    }
+    return 0;
+}
+
+#else
+
+struct jit_8080 *make_jit() {
+    return NULL;
+}
+
+void free_jit(struct jit_8080 *jit) {
+    (void) jit;
+}
+
+int jit8080_run(struct state_8080 *state, long n_instructions, uint64_t cycle_limit) {
+    (void) state;
+    (void) n_instructions;
+    (void) cycle_limit;
+    return 0;
+}
+
+void jit8080_invalidate(struct jit_8080 *jit, uint16_t offset) {
+    (void) jit;
+    (void) offset;
+}
+
+#endif
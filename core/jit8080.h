@@ -0,0 +1,28 @@
+#ifndef EMULATOR101_JIT8080_H
+#define EMULATOR101_JIT8080_H
+
+#include <stdint.h>
+
+#define JIT_CACHE_SIZE (4 << 20) // host code bytes, the whole cache is flushed when it fills up
+#define JIT_MAX_BLOCK 32 // 8080 instructions per translated block
+
+struct state_8080;
+struct jit_8080;
+
+// translates 8080 basic blocks to x86-64 the first time they run and keeps them in a code cache
+// keyed by pc. blocks end at jumps, calls and returns, IN, OUT, HLT, DAA and XTHL are left to
+// cpu_update.
+// returns NULL on other hosts or when executable memory is refused, the state then keeps interpreting
+struct jit_8080 *make_jit();
+
+void free_jit(struct jit_8080 *jit);
+
+// cpu_run and cpu_run_cycles come here while state->jit is set. stops exactly where the
+// interpreter would, a block that does not fit the remaining budget is interpreted instead
+int jit8080_run(struct state_8080 *state, long n_instructions, uint64_t cycle_limit);
+
+// drops every block translated from offset, memory8080_write calls it for each byte it changes.
+// a block that writes over its own code leaves right after that instruction
+void jit8080_invalidate(struct jit_8080 *jit, uint16_t offset);
+
+#endif //EMULATOR101_JIT8080_H
@@ -0,0 +1,292 @@
+#define _GNU_SOURCE // memfd_create
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "core8080.h"
+#include "memory8080.h"
+#include "jit8080.h"
+#include "block8080.h"
+#include "recomp8080.h"
+
+// a frozen copy of some state's memory, mapped private by it and the states forked from it
+struct memory_base_8080 {
+    int fd;
+    const uint8_t *bytes; // read only view, to tell whether a state still matches it
+    int references;
+};
+
+static size_t host_size() {
+    return MEMORY_HOST_SIZE + sysconf(_SC_PAGESIZE);
+}
+
+int memory8080_allocate(struct state_8080 *state) {
+    state->memory = mmap(NULL, host_size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return state->memory == MAP_FAILED ? -1 : 0;
+}
+
+static void release_base(struct memory_base_8080 *base) {
+    if (base == NULL || --base->references > 0) return;
+    munmap((void *) base->bytes, MEMORY_HOST_SIZE);
+    close(base->fd);
+    free(base);
+}
+
+void memory8080_release(struct state_8080 *state) {
+    munmap(state->memory, host_size());
+    release_base(state->base);
+}
+
+// maps both ranges to one memfd, so every engine indexing state->memory directly sees the
+// mirror without any help
+static int share(struct state_8080 *state, uint32_t offset, uint32_t size, uint32_t target) {
+#ifdef MFD_CLOEXEC
+    long host_page = sysconf(_SC_PAGESIZE);
+
+    if (offset % host_page || size % host_page || target % host_page) return -1;
+
+    int fd = memfd_create("emulator101", MFD_CLOEXEC);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, size) || pwrite(fd, state->memory + target, size, 0) != (ssize_t) size) {
+        close(fd);
+        return -1;
+    }
+    // the target first, should the mirror fail the target still holds the same bytes
+    int failed = mmap(state->memory + target, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+                 mmap(state->memory + offset, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED;
+    close(fd);
+    return failed ? -1 : 0;
+#else
+    return -1;
+#endif
+}
+
+// a mirror the host mapped together has to be mapped together again once its memory
+// was replaced, as a copying mirror if that fails. the bytes on both sides are equal already
+static void reshare(struct state_8080 *state) {
+    int page = 0;
+
+    while (page < MEMORY_PAGES) {
+        int end = page;
+        while (end < MEMORY_PAGES && (state->pages[end].flags & (MEM_MIRROR | MEM_COPY)) == MEM_MIRROR &&
+               state->pages[end].host == state->pages[page].host + ((end - page) << 8)) end++;
+        if (end == page) {
+            page++;
+            continue;
+        }
+
+        uint32_t target = state->pages[page].host - state->memory;
+        if (share(state, page << 8, (end - page) << 8, target)) {
+            for (int i = page; i < end; i++) {
+                uint8_t member = i;
+                do {
+                    state->pages[member].flags |= MEM_COPY;
+                    member = state->pages[member].next;
+                } while (member != i);
+            }
+        }
+        page = end;
+    }
+}
+
+static struct memory_base_8080 *make_base(const uint8_t *memory) {
+#ifdef MFD_CLOEXEC
+    int fd = memfd_create("emulator101-fork", MFD_CLOEXEC);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, MEMORY_HOST_SIZE) || pwrite(fd, memory, MEMORY_HOST_SIZE, 0) != MEMORY_HOST_SIZE) {
+        close(fd);
+        return NULL;
+    }
+
+    const uint8_t *bytes = mmap(NULL, MEMORY_HOST_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    if (bytes == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    struct memory_base_8080 *base = calloc(1, sizeof(struct memory_base_8080));
+    if (base == NULL) {
+        munmap((void *) bytes, MEMORY_HOST_SIZE);
+        close(fd);
+        return NULL;
+    }
+    base->fd = fd;
+    base->bytes = bytes;
+    return base;
+#else
+    return NULL;
+#endif
+}
+
+// state's memory becomes a private view of base
+static int map_base(struct state_8080 *state, struct memory_base_8080 *base) {
+    if (mmap(state->memory, MEMORY_HOST_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, base->fd, 0) == MAP_FAILED) {
+        return -1;
+    }
+    base->references++;
+    release_base(state->base);
+    state->base = base;
+    reshare(state);
+    return 0;
+}
+
+int memory8080_fork(struct state_8080 *parent, struct state_8080 *child) {
+    struct memory_base_8080 *base = parent->base;
+
+    // parent wrote since it was frozen, or never was
+    if (base == NULL || memcmp(parent->memory, base->bytes, MEMORY_HOST_SIZE) != 0) {
+        base = make_base(parent->memory);
+        if (base && map_base(parent, base)) {
+            base->references = 1;
+            release_base(base);
+            base = NULL;
+        }
+    }
+
+    child->base = NULL;
+    if (memory8080_allocate(child)) return -1;
+    for (int page = 0; page < MEMORY_PAGES; page++) {
+        child->pages[page].host = child->memory + (parent->pages[page].host - parent->memory);
+    }
+    if (base && map_base(child, base) == 0) return 0;
+
+    memcpy(child->memory, parent->memory, MEMORY_HOST_SIZE);
+    reshare(child);
+    return 0;
+}
+
+void memory8080_init(struct state_8080 *state, uint32_t mem_size, uint16_t ram_offset) {
+    for (int page = 0; page < MEMORY_PAGES; page++) {
+        int unmapped = (uint32_t) page << 8 >= mem_size;
+
+        // unmapped pages all read the page of zeros past MEMORY_HOST_SIZE, writes never reach it
+        state->pages[page].host = state->memory + (unmapped ? MEMORY_HOST_SIZE : page << 8);
+        state->pages[page].next = page;
+        state->pages[page].flags = unmapped ? MEM_UNMAPPED : 0;
+    }
+    for (int page = VRAM_ADDRESS >> 8; page < (VRAM_ADDRESS + VRAM_SIZE) >> 8; page++) {
+        state->pages[page].flags |= MEM_VRAM;
+    }
+    // the page ram_offset falls in stays writable
+    memory8080_protect(state, 0, ram_offset & 0xff00);
+    state->map_version++;
+}
+
+static int whole_pages(uint32_t offset, uint32_t size) {
+    return offset % 256 == 0 && size % 256 == 0 && offset + size <= MEMORY_HOST_SIZE;
+}
+
+int memory8080_protect(struct state_8080 *state, uint32_t offset, uint32_t size) {
+    if (!whole_pages(offset, size)) return -1;
+    for (uint32_t page = offset >> 8; page < (offset + size) >> 8; page++) state->pages[page].flags |= MEM_READ_ONLY;
+    state->map_version++;
+    return 0;
+}
+
+int memory8080_mirror(struct state_8080 *state, uint32_t offset, uint32_t size, uint32_t target) {
+    if (!whole_pages(offset, size) || !whole_pages(target, size)) return -1;
+    if (offset < target + size && target < offset + size) return -1;
+
+    for (uint32_t i = 0; i < size >> 8; i++) {
+        struct page_8080 *page = &state->pages[(offset >> 8) + i], *shown = &state->pages[(target >> 8) + i];
+        if (page->next != (offset >> 8) + i || (page->flags | shown->flags) & (MEM_MIRROR | MEM_UNMAPPED)) return -1;
+    }
+
+    // a target mirrored before keeps the memory it shares, a new mapping would cut it off
+    int mirrored = 0;
+    for (uint32_t page = target >> 8; page < (target + size) >> 8; page++) mirrored |= state->pages[page].next != page;
+
+    // the bytes at offset track the target either way, for whatever reads memory[] directly
+    memcpy(state->memory + offset, state->memory + target, size);
+    int copy = mirrored || share(state, offset, size, target) != 0;
+
+    for (uint32_t i = 0; i < size >> 8; i++) {
+        uint8_t number = (offset >> 8) + i;
+        struct page_8080 *page = &state->pages[number], *shown = &state->pages[(target >> 8) + i];
+
+        page->host = shown->host;
+        page->flags = (shown->flags & MEM_SLOW) | MEM_MIRROR;
+        page->next = shown->next;
+        shown->next = number;
+        if (!copy) continue;
+
+        // the whole ring, pages sharing memory with the target included
+        uint8_t member = number;
+        do {
+            state->pages[member].flags |= MEM_COPY;
+            member = state->pages[member].next;
+        } while (member != number);
+    }
+    state->map_version++;
+    return 0;
+}
+
+int memory8080_invaders(struct state_8080 *state) {
+    if (memory8080_protect(state, 0, ROM_SIZE)) return -1;
+    return memory8080_mirror(state, RAM_MIRROR_ADDRESS, RAM_SIZE, RAM_ADDRESS);
+}
+
+void memory8080_stats(const struct state_8080 *state, struct memory_stats_8080 *stats) {
+    *stats = state->memory_stats;
+}
+
+void memory8080_print_access(struct state_8080 *state, enum memory_access_8080 access, uint16_t offset) {
+    (void) state;
+    if (access == MEMORY_ROM_WRITE) fprintf(stderr, "Cannot Write To Offset %x, Part Of ROM\n", offset);
+    else fprintf(stderr, "Cannot Write To Offset %x, Not Mapped\n", offset);
+}
+
+// counted always, logged at most MEMORY_LOG_BURST times a second, so a rom hammering its
+// own code never runs at the speed of the log. wall time, the engines only write
+// state->cycles back when they stop
+static void illegal(struct state_8080 *state, enum memory_access_8080 access, uint16_t offset) {
+    struct memory_stats_8080 *stats = &state->memory_stats;
+
+    if (access == MEMORY_ROM_WRITE) stats->rom_writes++;
+    else stats->unmapped_writes++;
+    stats->last_offset = offset;
+    if (!state->log_access) return;
+
+    int64_t second = time(NULL);
+    if (second != stats->second) {
+        stats->second = second;
+        stats->logged_this_second = 0;
+    }
+    if (stats->logged_this_second == MEMORY_LOG_BURST) {
+        stats->suppressed++;
+        return;
+    }
+    stats->logged_this_second++;
+    stats->logged++;
+    state->log_access(state, access, offset);
+}
+
+void memory8080_write(struct state_8080 *state, uint16_t offset, uint8_t value) {
+    struct page_8080 *page = &state->pages[offset >> 8];
+
+    if (page->flags & (MEM_UNMAPPED | MEM_READ_ONLY)) {
+        illegal(state, page->flags & MEM_UNMAPPED ? MEMORY_UNMAPPED_WRITE : MEMORY_ROM_WRITE, offset);
+        return;
+    }
+    if (page->host[offset & 0xff] == value) return;
+    page->host[offset & 0xff] = value;
+
+    // every address showing the byte, code translated from any of them is stale
+    uint8_t first = offset >> 8, number = first;
+    do {
+        uint16_t alias = number << 8 | (offset & 0xff);
+        uint16_t vram_offset = alias - VRAM_ADDRESS;
+
+        if (state->pages[number].flags & MEM_COPY) state->memory[alias] = value;
+        if (state->jit) jit8080_invalidate(state->jit, alias);
+        if (state->blocks) block8080_invalidate(state->blocks, alias);
+        if (state->recomp) recomp8080_invalidate(state->recomp, alias);
+        if (vram_offset < VRAM_SIZE) {
+            state->vram_dirty[vram_offset / 256] |= (uint32_t) 1 << (vram_offset % 32);
+        }
+        number = state->pages[number].next;
+    } while (number != first);
+}
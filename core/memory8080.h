@@ -0,0 +1,90 @@
+#ifndef EMULATOR101_MEMORY8080_H
+#define EMULATOR101_MEMORY8080_H
+
+#include <stdint.h>
+
+#define MEMORY_PAGES 256 // of 256 bytes, the whole 16 bit address space
+#define MEMORY_HOST_SIZE 0x10000 // bytes make_state maps, memory[] is valid for any 16 bit offset
+#define MEMORY_LOG_BURST 8 // illegal accesses handed to the log per second, the rest are only counted
+
+#define MEM_READ_ONLY 0x01 // writes are dropped
+#define MEM_VRAM 0x02 // writes mark vram tiles dirty
+#define MEM_UNMAPPED 0x04 // past the state's memory, reads see zeros and writes are dropped
+#define MEM_MIRROR 0x08 // shows the bytes of another page
+#define MEM_COPY 0x10 // mirrored by copying every write, the host could not map both pages to the same memory
+
+// flags sending a write through memory8080_write. mirrors the host maps twice only need
+// it when some cache holds translated code
+#define MEM_SLOW (MEM_READ_ONLY | MEM_VRAM | MEM_UNMAPPED | MEM_COPY)
+
+struct state_8080;
+struct memory_base_8080;
+
+enum memory_access_8080 {
+    MEMORY_ROM_WRITE, // dropped, the page is read only
+    MEMORY_UNMAPPED_WRITE, // dropped, past the state's memory
+};
+
+// per state, nothing is printed unless state->log_access is set
+struct memory_stats_8080 {
+    uint64_t rom_writes;
+    uint64_t unmapped_writes;
+    uint64_t logged; // handed to state->log_access
+    uint64_t suppressed; // over MEMORY_LOG_BURST in their second
+    uint16_t last_offset; // of the last illegal access
+
+    // the second of wall time logged counts towards MEMORY_LOG_BURST
+    int64_t second;
+    uint32_t logged_this_second;
+};
+
+// one 256 byte page of the 8080's address space. host is where its bytes live, another
+// page's for a mirror. the pages showing the same bytes are linked in a ring through next,
+// a page on its own is its own next
+struct page_8080 {
+    uint8_t *host;
+    uint8_t flags;
+    uint8_t next;
+};
+
+// maps MEMORY_HOST_SIZE bytes and a page of zeros after them at state->memory, anonymous
+// so rom8080_load and mirrors can map over them. -1 when the host refuses
+int memory8080_allocate(struct state_8080 *state);
+
+void memory8080_release(struct state_8080 *state);
+
+// gives child, a copy of parent's struct, memory of its own with parent's bytes in it.
+// parent's memory is frozen into a copy both then map private, the host copies a page for
+// whichever of them writes it first. that is a host page, 4K on most, not one of the map's
+// 256 byte pages: the engines index state->memory directly, so copying on the map's pages
+// would cost a check on every store. as long as parent does not write, forking it again
+// reuses the copy and costs nothing but the pages the children write. copies everything
+// where the host has no memfd. -1 when the host refuses. not thread safe
+int memory8080_fork(struct state_8080 *parent, struct state_8080 *child);
+
+// plain ram up to mem_size, read only below ram_offset, vram flagged. make_state calls it
+void memory8080_init(struct state_8080 *state, uint32_t mem_size, uint16_t ram_offset);
+
+// makes [offset, offset + size) read only, whole pages. returns -1 for anything else
+int memory8080_protect(struct state_8080 *state, uint32_t offset, uint32_t size);
+
+// makes [offset, offset + size) show the bytes at target, whole pages that are neither
+// unmapped nor mirrored already. where offset, size and target fall on host pages both
+// ranges are mapped to the same memory and reads and writes run at full speed, elsewhere
+// writes to either range are copied to the other. returns -1 when the ranges do not qualify
+int memory8080_mirror(struct state_8080 *state, uint32_t offset, uint32_t size, uint32_t target);
+
+// space invaders' address decoding: 8K of rom, then 8K of ram that shows again at 0x4000
+int memory8080_invaders(struct state_8080 *state);
+
+// a copy of state->memory_stats
+void memory8080_stats(const struct state_8080 *state, struct memory_stats_8080 *stats);
+
+// a log_access printing to stderr
+void memory8080_print_access(struct state_8080 *state, enum memory_access_8080 access, uint16_t offset);
+
+// everything core8080_write_byte leaves out: read only and unmapped pages, vram, mirrors
+// and dropping translated code
+void memory8080_write(struct state_8080 *state, uint16_t offset, uint8_t value);
+
+#endif //EMULATOR101_MEMORY8080_H
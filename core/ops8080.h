@@ -0,0 +1,58 @@
+#ifndef EMULATOR101_OPS8080_H
+#define EMULATOR101_OPS8080_H
+
+// instruction bodies shared by the threaded engine and recompiled code. both keep the
+// registers in locals named after them, plus w, sum, value and tmp as scratch, and define
+// WRITE themselves. core8080.h goes first
+
+// the registers live in locals for the whole run and are only written back to the state
+// when leaving the loop or when handing an instruction over to cpu_update
+#define SPILL() do { \
+        state->a = a; state->b = b; state->c = c; state->d = d; \
+        state->e = e; state->h = h; state->l = l; \
+        state->sp = sp; state->pc = pc; \
+        state->cycles = cycles; \
+    } while (0)
+
+#define RELOAD() do { \
+        a = state->a; b = state->b; c = state->c; d = state->d; \
+        e = state->e; h = state->h; l = state->l; \
+        sp = state->sp; pc = state->pc; \
+        cycles = state->cycles; \
+    } while (0)
+
+#define WORD(hb, lb) ((uint16_t) ((hb) << 8 | (lb)))
+#define HL WORD(h, l)
+
+#define READ(offset) core8080_read_byte(state, (offset))
+
+#define PUSH(hb, lb) do { \
+        WRITE(sp - 1, (hb)); \
+        WRITE(sp - 2, (lb)); \
+        sp -= 2; \
+    } while (0)
+
+#define POP(hi, lo) do { \
+        lo = READ(sp); \
+        hi = READ(sp + 1); \
+        sp += 2; \
+    } while (0)
+
+#define INR(r) do { r += 1; FLAGS_INR(state, r); } while (0)
+#define DCR(r) do { r -= 1; FLAGS_DCR(state, r); } while (0)
+
+#define INX(hi, lo) do { w = WORD(hi, lo) + 1; hi = w >> 8; lo = w & 0xff; } while (0)
+#define DCX(hi, lo) do { w = WORD(hi, lo) - 1; hi = w >> 8; lo = w & 0xff; } while (0)
+
+#define ADD(v) do { value = (v); w = (uint16_t) a + value; FLAGS_ADD(state, a, value, w); a = w & 0xff; } while (0)
+#define ADC(v) do { value = (v); w = (uint16_t) a + value + FLAGS_READ(state).cy; FLAGS_ADD(state, a, value, w); a = w & 0xff; } while (0)
+#define SUB(v) do { value = (v); w = (uint16_t) a - value; FLAGS_SUB(state, a, value, w); a = w & 0xff; } while (0)
+#define SBB(v) do { value = (v); w = (uint16_t) a - value - FLAGS_READ(state).cy; FLAGS_SUB(state, a, value, w); a = w & 0xff; } while (0)
+#define ANA(v) do { value = (v); FLAGS_AND(state, a, value, a & value); a &= value; } while (0)
+#define XRA(v) do { a ^= (v); FLAGS_LOGIC(state, a); } while (0)
+#define ORA(v) do { a |= (v); FLAGS_LOGIC(state, a); } while (0)
+#define CMP(v) do { value = (v); w = (uint16_t) a - value; FLAGS_SUB(state, a, value, w); } while (0)
+
+#define DAD(v) do { sum = (uint32_t) HL + (v); FLAGS(state).cy = sum > 0xffff; h = sum >> 8; l = sum & 0xff; } while (0)
+
+#endif //EMULATOR101_OPS8080_H
@@ -0,0 +1,80 @@
+#include <stdlib.h>
+
+#include "profile8080.h"
+#include "disassembler.h"
+
+struct profile_entry {
+    uint32_t key; // pc or opcode
+    uint64_t count;
+    uint64_t cycles;
+};
+
+static int by_cycles(const void *a, const void *b) {
+    const struct profile_entry *x = a, *y = b;
+
+    if (x->cycles != y->cycles) return x->cycles < y->cycles ? 1 : -1;
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+static size_t collect(struct profile_entry *entries, const uint64_t *count, const uint64_t *cycles, size_t n) {
+    size_t used = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (count[i] == 0) continue;
+        entries[used].key = i;
+        entries[used].count = count[i];
+        entries[used].cycles = cycles[i];
+        used++;
+    }
+    qsort(entries, used, sizeof(struct profile_entry), by_cycles);
+    return used;
+}
+
+struct profile_8080 *make_profile() {
+    struct profile_8080 *profile = calloc(1, sizeof(struct profile_8080));
+    profile->previous = -1;
+    return profile;
+}
+
+void profile8080_report(FILE *out, const struct profile_8080 *profile, const uint8_t *memory) {
+    struct profile_entry *entries = malloc(0x10000 * sizeof(struct profile_entry));
+    uint64_t instructions = 0, cycles = 0;
+    char line[DISASSEMBLE_LINE_MAX + 1];
+
+    for (int i = 0; i < 256; i++) {
+        instructions += profile->opcode_count[i];
+        cycles += profile->opcode_cycles[i];
+    }
+    if (cycles == 0) cycles = 1;
+
+    size_t used = collect(entries, profile->pc_count, profile->pc_cycles, 0x10000);
+    fprintf(out, "profile: %llu instructions, %llu cycles, %zu addresses\n",
+            (unsigned long long) instructions, (unsigned long long) cycles, used);
+    fprintf(out, "%12s %12s %6s  instruction\n", "count", "cycles", "%");
+    for (size_t i = 0; i < used && i < PROFILE_REPORT_LINES; i++) {
+        disassemble_8080_to(line, sizeof(line), memory, entries[i].key);
+        fprintf(out, "%12llu %12llu %5.1f%%  %s\n", (unsigned long long) entries[i].count,
+                (unsigned long long) entries[i].cycles, 100.0 * entries[i].cycles / cycles, line);
+    }
+
+    used = collect(entries, profile->opcode_count, profile->opcode_cycles, 256);
+    fprintf(out, "\n%12s %12s %6s  opcode\n", "count", "cycles", "%");
+    for (size_t i = 0; i < used; i++) {
+        disassemble_8080_opcode(line, sizeof(line), entries[i].key);
+        fprintf(out, "%12llu %12llu %5.1f%%  %02x %s\n", (unsigned long long) entries[i].count,
+                (unsigned long long) entries[i].cycles, 100.0 * entries[i].cycles / cycles,
+                entries[i].key, line);
+    }
+
+    used = collect(entries, profile->pair_count, profile->pair_cycles, 0x10000);
+    fprintf(out, "\n%12s %12s %6s  opcode pair\n", "count", "cycles", "%");
+    for (size_t i = 0; i < used && i < PROFILE_REPORT_LINES; i++) {
+        char second[DISASSEMBLE_LINE_MAX + 1];
+        disassemble_8080_opcode(line, sizeof(line), entries[i].key >> 8);
+        disassemble_8080_opcode(second, sizeof(second), entries[i].key & 0xff);
+        fprintf(out, "%12llu %12llu %5.1f%%  %02x %02x %s; %s\n", (unsigned long long) entries[i].count,
+                (unsigned long long) entries[i].cycles, 100.0 * entries[i].cycles / cycles,
+                entries[i].key >> 8, entries[i].key & 0xff, line, second);
+    }
+    free(entries);
+}
@@ -0,0 +1,43 @@
+#ifndef EMULATOR101_PROFILE8080_H
+#define EMULATOR101_PROFILE8080_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define PROFILE_REPORT_LINES 32 // hottest addresses the report lists
+
+// executions and cycles per address and per opcode. cycles include the extra states of
+// taken conditional calls and returns, so they add up to state->cycles over the profiled run.
+// pairs are counted by the opcode before << 8 | the opcode after, whatever ran in between
+// the two, and are what the block cache's fused handlers were picked from
+struct profile_8080 {
+    uint64_t pc_count[0x10000];
+    uint64_t pc_cycles[0x10000];
+    uint64_t opcode_count[256];
+    uint64_t opcode_cycles[256];
+    uint64_t pair_count[0x10000];
+    uint64_t pair_cycles[0x10000];
+    int previous; // opcode of the last instruction recorded, -1 before the first
+    uint64_t previous_cycles;
+};
+
+struct profile_8080 *make_profile();
+
+static inline void profile8080_record(struct profile_8080 *profile, uint16_t pc, uint8_t opcode, uint64_t cycles) {
+    profile->pc_count[pc] += 1;
+    profile->pc_cycles[pc] += cycles;
+    profile->opcode_count[opcode] += 1;
+    profile->opcode_cycles[opcode] += cycles;
+    if (profile->previous >= 0) {
+        profile->pair_count[profile->previous << 8 | opcode] += 1;
+        profile->pair_cycles[profile->previous << 8 | opcode] += profile->previous_cycles + cycles;
+    }
+    profile->previous = opcode;
+    profile->previous_cycles = cycles;
+}
+
+// the hottest addresses by cycles, disassembled from memory as it is now, followed by
+// every opcode that executed and the hottest opcode pairs, also by cycles
+void profile8080_report(FILE *out, const struct profile_8080 *profile, const uint8_t *memory);
+
+#endif //EMULATOR101_PROFILE8080_H
@@ -0,0 +1,24 @@
+#include <stdlib.h>
+
+#include "recomp8080.h"
+#include "util.h"
+
+// the rom translated into this binary, see the emulator101-recomp make target
+#ifdef RECOMPILED
+extern const struct recompiled_8080 recompiled_rom;
+static const struct recompiled_8080 *compiled = &recompiled_rom;
+#else
+static const struct recompiled_8080 *compiled = NULL;
+#endif
+
+struct recomp_8080 *make_recomp(const uint8_t *memory) {
+    if (compiled == NULL || hash_bytes(memory, compiled->size) != compiled->hash) return NULL;
+
+    struct recomp_8080 *recomp = calloc(1, sizeof(struct recomp_8080));
+    recomp->code = compiled;
+    return recomp;
+}
+
+void free_recomp(struct recomp_8080 *recomp) {
+    free(recomp);
+}
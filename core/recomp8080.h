@@ -0,0 +1,54 @@
+#ifndef EMULATOR101_RECOMP8080_H
+#define EMULATOR101_RECOMP8080_H
+
+#include <stdint.h>
+
+struct state_8080;
+
+// a rom translated to C ahead of time by recomp8080, `make emulator101-recomp` links one in
+struct recompiled_8080 {
+    uint64_t hash; // hash_bytes of the image it was translated from
+    uint32_t size; // bytes of the image, loaded at 0x0000
+    int (*run)(struct state_8080 *state, long n_instructions, uint64_t cycle_limit);
+};
+
+struct recomp_8080 {
+    const struct recompiled_8080 *code;
+    uint8_t modified[256]; // pages of the image written since make_recomp, interpreted from then on
+    int stale; // a write modified a page, the running block leaves after the instruction
+};
+
+// NULL unless this binary has a translation of the image memory starts with
+struct recomp_8080 *make_recomp(const uint8_t *memory);
+
+void free_recomp(struct recomp_8080 *recomp);
+
+// memory8080_write calls it for each byte it changes
+static inline void recomp8080_invalidate(struct recomp_8080 *recomp, uint16_t offset) {
+    if (offset >= recomp->code->size || recomp->modified[offset >> 8]) return;
+    recomp->modified[offset >> 8] = 1;
+    recomp->stale = 1;
+}
+
+// used by the generated code. a block runs whole or not at all: it needs n instructions and
+// its last one has to start before the cycle limit, like the interpreter would, and none of
+// its pages may have been modified
+#define RECOMP_ENTER(n, before_last, total, first_page, last_page) do { \
+        if (remaining < (n) || cycles + (before_last) >= cycle_limit || \
+            recomp->modified[first_page] || recomp->modified[last_page]) goto slow; \
+        remaining -= (n); \
+        cycles += (total); \
+    } while (0)
+
+// after an instruction that wrote memory, gives back what the rest of the block was charged
+#define RECOMP_STALE(next, n_left, cycles_left) do { \
+        if (recomp->stale) { \
+            recomp->stale = 0; \
+            remaining += (n_left); \
+            cycles -= (cycles_left); \
+            pc = (next); \
+            goto dispatch; \
+        } \
+    } while (0)
+
+#endif //EMULATOR101_RECOMP8080_H
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "rom8080.h"
+#include "core8080.h"
+
+#define MANIFEST_SUFFIX ".manifest"
+#define LINE_LENGTH 1024
+
+static int add_segment(struct rom_8080 *rom, const char *path, uint32_t offset) {
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) return -1;
+    if (rom->n_segments == ROM_MAX_SEGMENTS || fstat(fd, &info) || offset + info.st_size > 0x10000) {
+        close(fd);
+        return -1;
+    }
+
+    // kept sorted, a segment mapped at a page boundary would zero whatever went before it
+    // in its last page
+    int i = rom->n_segments++;
+    while (i > 0 && rom->segments[i - 1].offset > offset) {
+        rom->segments[i] = rom->segments[i - 1];
+        i--;
+    }
+    rom->segments[i].fd = fd;
+    rom->segments[i].offset = offset;
+    rom->segments[i].size = info.st_size;
+    return 0;
+}
+
+static int skip_line(const char *line) {
+    while (*line == ' ' || *line == '\t') line++;
+    return *line == '#' || *line == '\n' || *line == '\r' || *line == '\0';
+}
+
+static int read_manifest(struct rom_8080 *rom, const char *path) {
+    char line[LINE_LENGTH], file[LINE_LENGTH], resolved[2 * LINE_LENGTH];
+    const char *slash = strrchr(path, '/');
+    int directory = slash ? (int) (slash - path + 1) : 0;
+    FILE *fd = fopen(path, "r");
+
+    if (fd == NULL) return -1;
+    while (fgets(line, sizeof(line), fd)) {
+        long offset;
+
+        if (skip_line(line)) continue;
+        if (sscanf(line, "%li %1023[^\r\n]", &offset, file) != 2 || offset < 0) {
+            fclose(fd);
+            return -1;
+        }
+        if (file[0] == '/') snprintf(resolved, sizeof(resolved), "%s", file);
+        else snprintf(resolved, sizeof(resolved), "%.*s%s", directory, path, file);
+        if (add_segment(rom, resolved, offset)) {
+            fclose(fd);
+            return -1;
+        }
+    }
+    fclose(fd);
+    return 0;
+}
+
+struct rom_8080 *open_rom(const char *path) {
+    size_t length = strlen(path), suffix = strlen(MANIFEST_SUFFIX);
+
+    if (length < suffix || strcmp(path + length - suffix, MANIFEST_SUFFIX) != 0) return open_rom_file(path, 0);
+
+    struct rom_8080 *rom = calloc(1, sizeof(struct rom_8080));
+    if (read_manifest(rom, path)) {
+        close_rom(rom);
+        return NULL;
+    }
+    return rom;
+}
+
+struct rom_8080 *open_rom_file(const char *path, uint32_t offset) {
+    struct rom_8080 *rom = calloc(1, sizeof(struct rom_8080));
+
+    if (add_segment(rom, path, offset)) {
+        free(rom);
+        return NULL;
+    }
+    return rom;
+}
+
+void close_rom(struct rom_8080 *rom) {
+    for (int i = 0; i < rom->n_segments; i++) close(rom->segments[i].fd);
+    free(rom);
+}
+
+static int load_segment(const struct rom_segment_8080 *segment, struct state_8080 *state) {
+    long page = sysconf(_SC_PAGESIZE);
+    uint32_t size = segment->size;
+
+    if (segment->offset >= state->memory_size) return 0;
+    if (size > state->memory_size - segment->offset) size = state->memory_size - segment->offset;
+    if (size == 0) return 0;
+
+    if (segment->offset % page == 0) {
+        void *at = mmap(state->memory + segment->offset, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_FIXED, segment->fd, 0);
+        if (at != MAP_FAILED) return 0;
+    }
+    return pread(segment->fd, state->memory + segment->offset, size, 0) == size ? 0 : -1;
+}
+
+int rom8080_load(const struct rom_8080 *rom, struct state_8080 *state) {
+    for (int i = 0; i < rom->n_segments; i++) {
+        if (load_segment(&rom->segments[i], state)) return -1;
+    }
+    return 0;
+}
+
+int load_rom(struct state_8080 *state, const char *path) {
+    struct rom_8080 *rom = open_rom(path);
+
+    if (rom == NULL) return -1;
+    int result = rom8080_load(rom, state);
+    close_rom(rom);
+    return result;
+}
@@ -0,0 +1,44 @@
+#ifndef EMULATOR101_ROM8080_H
+#define EMULATOR101_ROM8080_H
+
+#include <stdint.h>
+
+#define ROM_MAX_SEGMENTS 16
+
+struct state_8080;
+
+// one file of a rom and where it goes in the address space
+struct rom_segment_8080 {
+    int fd;
+    uint32_t offset;
+    uint32_t size;
+};
+
+// a rom image, either a single file loaded at 0x0000 or a manifest of several. a manifest
+// has a name ending in .manifest and an "offset file" line per segment, files relative to
+// the manifest. blank lines and lines starting with # are skipped. the files stay open so
+// any number of states can be loaded from them
+struct rom_8080 {
+    struct rom_segment_8080 segments[ROM_MAX_SEGMENTS]; // by offset
+    int n_segments;
+};
+
+// NULL when a file is missing or the manifest is malformed
+struct rom_8080 *open_rom(const char *path);
+
+// a single file at offset
+struct rom_8080 *open_rom_file(const char *path, uint32_t offset);
+
+void close_rom(struct rom_8080 *rom);
+
+// maps every segment that starts on a host page straight into state->memory, private and
+// backed by the page cache, so every instance loaded from the same file shares one copy
+// until it writes. the others, and the pages they land in, are copied. whatever lies past
+// the state's memory is left out. load before setting up mirrors, the mappings replace
+// whatever was there. returns -1 when a file cannot be read
+int rom8080_load(const struct rom_8080 *rom, struct state_8080 *state);
+
+// open_rom, rom8080_load and close_rom
+int load_rom(struct state_8080 *state, const char *path);
+
+#endif //EMULATOR101_ROM8080_H
@@ -0,0 +1,189 @@
+#include <stdint.h>
+#include <limits.h>
+
+#include "core8080.h"
+#include "cycles8080.h"
+#include "run8080.h"
+#include "profile8080.h"
+#include "jit8080.h"
+#include "block8080.h"
+#include "ops8080.h"
+#include "recomp8080.h"
+
+// steps the switch interpreter, which records every instruction when state->trace is set and
+// counts it when state->profile is. both are bound by memory traffic rather than dispatch,
+// so the threaded engine stays free of them
+static int step(struct state_8080 *state, long n_instructions, uint64_t cycle_limit) {
+    while (n_instructions-- > 0 && state->cycles < cycle_limit) {
+        uint16_t pc = state->pc;
+        uint8_t opcode = state->memory[pc];
+        uint64_t cycles = state->cycles;
+        int halted = cpu_update(state);
+
+        if (state->profile) profile8080_record(state->profile, pc, opcode, state->cycles - cycles);
+        if (halted) return 1;
+    }
+    return 0;
+}
+
+#if !defined(__GNUC__)
+
+// no computed goto on this compiler. recompiled code is plain C and still runs, everything
+// else steps the switch interpreter
+int cpu_run(struct state_8080 *state, int n_instructions) {
+    if (state->recomp && !state->trace && !state->profile) {
+        return state->recomp->code->run(state, n_instructions, UINT64_MAX);
+    }
+    return step(state, n_instructions, UINT64_MAX);
+}
+
+int cpu_run_cycles(struct state_8080 *state, uint64_t budget) {
+    if (state->recomp && !state->trace && !state->profile) {
+        return state->recomp->code->run(state, LONG_MAX, state->cycles + budget);
+    }
+    return step(state, LONG_MAX, state->cycles + budget);
+}
+
+#else
+
+#define NEXT(len) do { pc += (len); DISPATCH(); } while (0)
+
+#define IMM16 WORD(opcode[2], opcode[1])
+
+#define JUMP_IF(cond) do { \
+        if (cond) pc = IMM16; \
+        else pc += 3; \
+        DISPATCH(); \
+    } while (0)
+
+#define CALL() do { \
+        w = pc + 3; \
+        pc = IMM16; \
+        PUSH(w >> 8, w & 0xff); \
+        DISPATCH(); \
+    } while (0)
+
+#define RET() do { \
+        POP(value, tmp); \
+        pc = WORD(value, tmp); \
+        DISPATCH(); \
+    } while (0)
+
+#define CALL_IF(cond) do { \
+        if (cond) { \
+            cycles += CYCLES_8080_TAKEN; \
+            CALL(); \
+        } \
+        NEXT(3); \
+    } while (0)
+
+#define RET_IF(cond) do { \
+        if (cond) { \
+            cycles += CYCLES_8080_TAKEN; \
+            RET(); \
+        } \
+        NEXT(1); \
+    } while (0)
+
+#define FUSED_HANDLER(first, second, name) &&fuse_##name,
+
+// fetches every instruction from memory. stops on whichever runs out first, the
+// instruction count or the cycle budget. nothing dispatches to the fused handlers here,
+// FUSE only keeps them correct
+#define ENGINE run
+#define ENGINE_LOCALS
+#define RESYNC()
+
+#define DISPATCH() do { \
+        if (--remaining < 0 || cycles >= cycle_limit) goto done; \
+        opcode = &memory[pc]; \
+        cycles += cycles_8080[opcode[0]]; \
+        goto *dispatch[opcode[0]]; \
+    } while (0)
+
+#define FUSE(len) do { \
+        pc += (len); \
+        if (--remaining < 0 || cycles >= cycle_limit) goto done; \
+        opcode = &memory[pc]; \
+        cycles += cycles_8080[opcode[0]]; \
+    } while (0)
+
+#define WRITE(offset, value) core8080_write_byte(state, (offset), (value))
+
+#include "threaded8080.h"
+
+#undef ENGINE
+#undef ENGINE_LOCALS
+#undef RESYNC
+#undef DISPATCH
+#undef FUSE
+#undef WRITE
+
+// runs from state->blocks, the next micro-op is taken as long as its pc is the one the
+// last instruction left. anything else, a jump or the end of a block, looks pc up again
+// and decodes the block there the first time it runs
+static const struct uop_8080 block_miss = {.handler = NULL, .pc = BLOCK_END};
+
+#define ENGINE run_blocks
+#define ENGINE_LOCALS \
+    struct block_cache_8080 *blocks = state->blocks; \
+    const struct uop_8080 *uop = &block_miss;
+
+// the switch interpreter may have written over decoded code
+#define RESYNC() do { uop = &block_miss; } while (0)
+
+#define DISPATCH() do { \
+        if (--remaining < 0 || cycles >= cycle_limit) goto done; \
+        if (uop->pc != pc) { \
+            uop = blocks->entry[pc]; \
+            if (!uop) uop = block8080_decode(blocks, memory, pc, dispatch); \
+            if (!uop) { \
+                uop = &block_miss; \
+                opcode = &memory[pc]; \
+                cycles += cycles_8080[opcode[0]]; \
+                goto *dispatch[opcode[0]]; \
+            } \
+        } \
+        opcode = uop->bytes; \
+        cycles += uop->cycles; \
+        goto *(uop++)->handler; \
+    } while (0)
+
+// the second micro-op of a pair, unless a write in the first half dropped the block
+#define FUSE(len) do { \
+        pc += (len); \
+        if (uop->pc != pc) DISPATCH(); \
+        if (--remaining < 0 || cycles >= cycle_limit) goto done; \
+        opcode = uop->bytes; \
+        cycles += uop->cycles; \
+        uop++; \
+    } while (0)
+
+// a write that dropped blocks may have dropped the running one
+#define WRITE(offset, value) do { \
+        core8080_write_byte(state, (offset), (value)); \
+        if (blocks->dropped) { \
+            blocks->dropped = 0; \
+            uop = &block_miss; \
+        } \
+    } while (0)
+
+#include "threaded8080.h"
+
+int cpu_run(struct state_8080 *state, int n_instructions) {
+    if (state->trace || state->profile) return step(state, n_instructions, UINT64_MAX);
+    if (state->recomp) return state->recomp->code->run(state, n_instructions, UINT64_MAX);
+    if (state->jit) return jit8080_run(state, n_instructions, UINT64_MAX);
+    if (state->blocks) return run_blocks(state, n_instructions, UINT64_MAX);
+    return run(state, n_instructions, UINT64_MAX);
+}
+
+int cpu_run_cycles(struct state_8080 *state, uint64_t budget) {
+    if (state->trace || state->profile) return step(state, LONG_MAX, state->cycles + budget);
+    if (state->recomp) return state->recomp->code->run(state, LONG_MAX, state->cycles + budget);
+    if (state->jit) return jit8080_run(state, LONG_MAX, state->cycles + budget);
+    if (state->blocks) return run_blocks(state, LONG_MAX, state->cycles + budget);
+    return run(state, LONG_MAX, state->cycles + budget);
+}
+
+#endif
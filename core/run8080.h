@@ -0,0 +1,17 @@
+#ifndef EMULATOR101_RUN8080_H
+#define EMULATOR101_RUN8080_H
+
+#include <stdint.h>
+
+struct state_8080;
+
+// threaded execution engine, runs up to n_instructions without returning to the caller.
+// fetches from state->blocks instead of memory while it is set.
+// returns 1 when the cpu halted (pc is left on the HLT), 0 otherwise
+int cpu_run(struct state_8080 *state, int n_instructions);
+
+// same engine, but runs until at least budget more cycles have been executed.
+// the last instruction may overshoot the budget, state->cycles has the exact count
+int cpu_run_cycles(struct state_8080 *state, uint64_t budget);
+
+#endif //EMULATOR101_RUN8080_H
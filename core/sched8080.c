@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "sched8080.h"
+#include "core8080.h"
+#include "run8080.h"
+
+static void swap_events(struct event_8080 *x, struct event_8080 *y) {
+    struct event_8080 tmp = *x;
+    *x = *y;
+    *y = tmp;
+}
+
+static void sift_up(struct scheduler_8080 *sched, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (sched->events[parent].cycle <= sched->events[i].cycle) break;
+        swap_events(&sched->events[parent], &sched->events[i]);
+        i = parent;
+    }
+}
+
+static void sift_down(struct scheduler_8080 *sched, int i) {
+    for (;;) {
+        int left = 2 * i + 1, right = left + 1, min = i;
+        if (left < sched->count && sched->events[left].cycle < sched->events[min].cycle) min = left;
+        if (right < sched->count && sched->events[right].cycle < sched->events[min].cycle) min = right;
+        if (min == i) break;
+        swap_events(&sched->events[min], &sched->events[i]);
+        i = min;
+    }
+}
+
+static void remove_at(struct scheduler_8080 *sched, int i) {
+    sched->count -= 1;
+    if (i == sched->count) return;
+    sched->events[i] = sched->events[sched->count];
+    sift_down(sched, i);
+    sift_up(sched, i);
+}
+
+struct scheduler_8080 *make_scheduler() {
+    return calloc(1, sizeof(struct scheduler_8080));
+}
+
+int sched8080_add(struct scheduler_8080 *sched, uint64_t cycle, uint64_t period,
+                  event_callback_8080 callback, void *context) {
+    if (sched->count == SCHED_MAX_EVENTS) return -1;
+
+    struct event_8080 *event = &sched->events[sched->count];
+    event->cycle = cycle;
+    event->period = period;
+    event->callback = callback;
+    event->context = context;
+    sched->count += 1;
+    sift_up(sched, sched->count - 1);
+    return 0;
+}
+
+int sched8080_cancel(struct scheduler_8080 *sched, event_callback_8080 callback, void *context) {
+    int dropped = 0;
+    for (int i = sched->count - 1; i >= 0; i--) {
+        if (sched->events[i].callback == callback && sched->events[i].context == context) {
+            remove_at(sched, i);
+            dropped++;
+        }
+    }
+    return dropped;
+}
+
+uint64_t sched8080_next(struct scheduler_8080 *sched) {
+    if (sched->count == 0) return UINT64_MAX;
+    return sched->events[0].cycle;
+}
+
+void sched8080_fire(struct scheduler_8080 *sched, struct state_8080 *state) {
+    while (sched->count > 0 && sched->events[0].cycle <= state->cycles) {
+        struct event_8080 event = sched->events[0];
+
+        // re-arm before the callback runs so it is free to cancel or add events
+        if (event.period) {
+            sched->events[0].cycle += event.period;
+            sift_down(sched, 0);
+        } else {
+            remove_at(sched, 0);
+        }
+        event.callback(state, event.context);
+    }
+}
+
+int cpu_run_scheduled(struct state_8080 *state, struct scheduler_8080 *sched, uint64_t budget) {
+    uint64_t end = state->cycles + budget;
+
+    while (state->cycles < end) {
+        uint64_t next = sched8080_next(sched);
+        if (next > end) next = end;
+
+        // halted, nothing runs until an event interrupts the cpu
+        if (cpu_run_cycles(state, next > state->cycles ? next - state->cycles : 0) && state->halted) {
+            if (!state->int_enable || sched->count == 0) return 1;
+            next = sched8080_next(sched);
+            state->cycles = next < end ? next : end;
+        }
+        sched8080_fire(sched, state);
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef EMULATOR101_SCHED8080_H
+#define EMULATOR101_SCHED8080_H
+
+#include <stdint.h>
+
+#define SCHED_MAX_EVENTS 32
+
+struct state_8080;
+
+typedef void (*event_callback_8080)(struct state_8080 *state, void *context);
+
+struct event_8080 {
+    uint64_t cycle;
+    uint64_t period; // 0 for one shot events, otherwise re-armed period cycles after it was due
+    event_callback_8080 callback;
+    void *context;
+};
+
+// min-heap on cycle, events[0] is always the next one due
+struct scheduler_8080 {
+    struct event_8080 events[SCHED_MAX_EVENTS];
+    int count;
+};
+
+struct scheduler_8080 *make_scheduler();
+
+// returns -1 when the scheduler is full
+int sched8080_add(struct scheduler_8080 *sched, uint64_t cycle, uint64_t period,
+                  event_callback_8080 callback, void *context);
+
+// drops every event with this callback and context, returns how many were dropped
+int sched8080_cancel(struct scheduler_8080 *sched, event_callback_8080 callback, void *context);
+
+// cycle of the next event, UINT64_MAX when nothing is scheduled
+uint64_t sched8080_next(struct scheduler_8080 *sched);
+
+// runs the callbacks of every event due at state->cycles, in cycle order
+void sched8080_fire(struct scheduler_8080 *sched, struct state_8080 *state);
+
+// runs the cpu for budget cycles, stopping the engine exactly at every event so the loop
+// checks a single cycle limit per instruction instead of polling devices.
+// a halted cpu with interrupts enabled idles until the next event, returns 1 when it can never wake
+int cpu_run_scheduled(struct state_8080 *state, struct scheduler_8080 *sched, uint64_t budget);
+
+#endif //EMULATOR101_SCHED8080_H
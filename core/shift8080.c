@@ -0,0 +1,28 @@
+#include "shift8080.h"
+#include "io8080.h"
+
+static uint8_t read_result(void *context, int port) {
+    struct shift_register_8080 *shifter = context;
+    (void) port;
+    return (shifter->value >> (8 - shifter->offset)) & 0xff;
+}
+
+static void write_offset(void *context, int port, uint8_t value) {
+    struct shift_register_8080 *shifter = context;
+    (void) port;
+    shifter->offset = value & 0x07;
+}
+
+static void write_data(void *context, int port, uint8_t value) {
+    struct shift_register_8080 *shifter = context;
+    (void) port;
+    shifter->value = (uint16_t) (value << 8 | shifter->value >> 8);
+}
+
+void shift8080_install(struct io_8080 *io, struct shift_register_8080 *shifter) {
+    shifter->value = 0;
+    shifter->offset = 0;
+    io8080_attach(io, SHIFT_OFFSET_PORT, NULL, write_offset, shifter);
+    io8080_attach(io, SHIFT_RESULT_PORT, read_result, NULL, shifter);
+    io8080_attach(io, SHIFT_DATA_PORT, NULL, write_data, shifter);
+}
@@ -0,0 +1,24 @@
+#ifndef EMULATOR101_SHIFT8080_H
+#define EMULATOR101_SHIFT8080_H
+
+#include <stdint.h>
+
+#define SHIFT_OFFSET_PORT 2 // OUT, IN 2 stays the second player's inputs
+#define SHIFT_RESULT_PORT 3 // IN, OUT 3 stays the sound latch
+#define SHIFT_DATA_PORT 4 // OUT
+
+struct io_8080;
+
+// space invaders' external shift register. every byte written to SHIFT_DATA_PORT enters
+// at the top and moves the previous one down, SHIFT_RESULT_PORT reads the 8 bits that
+// start SHIFT_OFFSET_PORT bits below the top. the caller owns the storage, nothing is
+// allocated
+struct shift_register_8080 {
+    uint16_t value;
+    uint8_t offset;
+};
+
+// attaches the register to its three ports of io
+void shift8080_install(struct io_8080 *io, struct shift_register_8080 *shifter);
+
+#endif //EMULATOR101_SHIFT8080_H
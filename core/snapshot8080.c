@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core8080.h"
+#include "snapshot8080.h"
+#include "io8080.h"
+#include "util.h"
+#include "jit8080.h"
+#include "block8080.h"
+#include "recomp8080.h"
+
+// the read only pages at the bottom of memory
+static uint32_t rom_size(struct state_8080 *state) {
+    uint32_t page = 0;
+
+    while (page < MEMORY_PAGES && (state->pages[page].flags & MEM_READ_ONLY)) page++;
+    return page << 8 < state->memory_size ? page << 8 : state->memory_size;
+}
+
+size_t snapshot_size(struct state_8080 *state) {
+    return sizeof(struct snapshot_8080) + state->memory_size - rom_size(state);
+}
+
+size_t snapshot_save(struct state_8080 *state, void *buffer, size_t size) {
+    struct snapshot_8080 *snapshot = buffer;
+    uint32_t rom = rom_size(state);
+
+    if (size < snapshot_size(state)) return 0;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->magic = SNAPSHOT_MAGIC;
+    snapshot->version = SNAPSHOT_VERSION;
+    snapshot->a = state->a;
+    snapshot->b = state->b;
+    snapshot->c = state->c;
+    snapshot->d = state->d;
+    snapshot->e = state->e;
+    snapshot->h = state->h;
+    snapshot->l = state->l;
+    snapshot->psw = pack_flags(state);
+    snapshot->int_enable = state->int_enable;
+    snapshot->halted = state->halted;
+    snapshot->sp = state->sp;
+    snapshot->pc = state->pc;
+    snapshot->cycles = state->cycles;
+    snapshot->rom_hash = hash_bytes(state->memory, rom);
+    snapshot->rom_size = rom;
+    snapshot->ram_size = state->memory_size - rom;
+    if (state->io) memcpy(snapshot->ports, state->io->ports, sizeof(snapshot->ports));
+    memcpy(snapshot + 1, state->memory + rom, snapshot->ram_size);
+    return snapshot_size(state);
+}
+
+// the bytes at offset, up to the end of its page
+static void restore_page(struct state_8080 *state, uint32_t offset, const uint8_t *bytes, uint32_t length) {
+    uint8_t *host = state->memory + offset;
+
+    if (memcmp(host, bytes, length) == 0) return;
+    memcpy(host, bytes, length);
+    for (uint32_t i = offset; i < offset + length; i++) {
+        if (state->jit) jit8080_invalidate(state->jit, i);
+        if (state->blocks) block8080_invalidate(state->blocks, i);
+        if (state->recomp) recomp8080_invalidate(state->recomp, i);
+    }
+}
+
+int snapshot_load(struct state_8080 *state, const void *buffer, size_t size) {
+    const struct snapshot_8080 *snapshot = buffer;
+    uint32_t rom = rom_size(state);
+
+    if (size < sizeof(*snapshot) || snapshot->magic != SNAPSHOT_MAGIC || snapshot->version != SNAPSHOT_VERSION) {
+        return -1;
+    }
+    if (snapshot->rom_size != rom || snapshot->ram_size != state->memory_size - rom ||
+        size < snapshot_size(state) || snapshot->rom_hash != hash_bytes(state->memory, rom)) {
+        return -1;
+    }
+
+    state->a = snapshot->a;
+    state->b = snapshot->b;
+    state->c = snapshot->c;
+    state->d = snapshot->d;
+    state->e = snapshot->e;
+    state->h = snapshot->h;
+    state->l = snapshot->l;
+    unpack_flags(state, snapshot->psw);
+    state->int_enable = snapshot->int_enable;
+    state->halted = snapshot->halted;
+    state->sp = snapshot->sp;
+    state->pc = snapshot->pc;
+    state->cycles = snapshot->cycles;
+    if (state->io) memcpy(state->io->ports, snapshot->ports, sizeof(snapshot->ports));
+
+    const uint8_t *ram = (const uint8_t *) (snapshot + 1);
+    for (uint32_t offset = rom; offset < state->memory_size; offset = (offset & ~0xff) + 0x100) {
+        uint32_t end = (offset & ~0xff) + 0x100 < state->memory_size ? (offset & ~0xff) + 0x100 : state->memory_size;
+        restore_page(state, offset, ram + offset - rom, end - offset);
+    }
+    memset(state->vram_dirty, 0xff, sizeof(state->vram_dirty));
+    return 0;
+}
+
+int snapshot_save_file(struct state_8080 *state, const char *path) {
+    size_t size = snapshot_size(state);
+    void *buffer = malloc(size);
+    FILE *fd = fopen(path, "wb");
+    int result = -1;
+
+    if (fd && snapshot_save(state, buffer, size) == size && fwrite(buffer, 1, size, fd) == size) result = 0;
+    if (fd && fclose(fd)) result = -1;
+    free(buffer);
+    return result;
+}
+
+int snapshot_load_file(struct state_8080 *state, const char *path) {
+    size_t size = snapshot_size(state);
+    void *buffer = malloc(size);
+    FILE *fd = fopen(path, "rb");
+    int result = -1;
+
+    if (fd && fread(buffer, 1, size, fd) == size) result = snapshot_load(state, buffer, size);
+    if (fd) fclose(fd);
+    free(buffer);
+    return result;
+}
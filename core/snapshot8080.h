@@ -0,0 +1,47 @@
+#ifndef EMULATOR101_SNAPSHOT8080_H
+#define EMULATOR101_SNAPSHOT8080_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SNAPSHOT_MAGIC 0x30383038 // "8080" in a little endian file
+#define SNAPSHOT_VERSION 2
+
+struct state_8080;
+
+// a snapshot is this header and then ram_size bytes of memory from rom_size on. the rom,
+// the read only pages at the bottom of memory, is left out and only checked by hash.
+// fields are in host byte order, snapshots are for warm starting on the machine that saved them
+struct snapshot_8080 {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t a, b, c, d, e, h, l;
+    uint8_t psw; // flags as PUSH PSW stores them
+    uint8_t int_enable;
+    uint8_t halted;
+    uint16_t sp;
+    uint16_t pc;
+    uint64_t cycles;
+    uint64_t rom_hash; // hash_bytes of the rom
+    uint32_t rom_size;
+    uint32_t ram_size;
+    uint8_t ports[256]; // latched bytes, devices keep their own state
+};
+
+// bytes snapshot_save needs for state
+size_t snapshot_size(struct state_8080 *state);
+
+// returns the bytes written, 0 when size is too small
+size_t snapshot_save(struct state_8080 *state, void *buffer, size_t size);
+
+// restores into a state made like the one saved, with the same rom loaded. memory is
+// copied a page at a time, code translated from the pages that change is dropped and the
+// whole screen redrawn. restore before arming a scheduler, events are due at absolute cycles.
+// returns -1 and leaves state alone when the snapshot is of another version, rom or memory size
+int snapshot_load(struct state_8080 *state, const void *buffer, size_t size);
+
+int snapshot_save_file(struct state_8080 *state, const char *path);
+
+int snapshot_load_file(struct state_8080 *state, const char *path);
+
+#endif //EMULATOR101_SNAPSHOT8080_H
@@ -0,0 +1,451 @@
+// the threaded engine's handlers, run8080.c includes this once per way of fetching
+// instructions. it defines ENGINE, ENGINE_LOCALS, DISPATCH, FUSE, WRITE and RESYNC before each
+// inclusion, which is why there is no include guard
+
+static int ENGINE(struct state_8080 *state, long n_instructions, uint64_t cycle_limit) {
+    // every opcode defaults to the fallback and the ones with a handler override it, which is
+    // the point of the range initializer rather than a mistake
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+    static const void *dispatch[] = {
+            [0 ... 255] = &&op_fallback,
+
+            [0x00] = &&op_0x00, [0x01] = &&op_0x01, [0x02] = &&op_0x02, [0x03] = &&op_0x03,
+            [0x04] = &&op_0x04, [0x05] = &&op_0x05, [0x06] = &&op_0x06, [0x07] = &&op_0x07,
+            [0x09] = &&op_0x09, [0x0a] = &&op_0x0a, [0x0b] = &&op_0x0b, [0x0c] = &&op_0x0c,
+            [0x0d] = &&op_0x0d, [0x0e] = &&op_0x0e, [0x0f] = &&op_0x0f,
+            [0x11] = &&op_0x11, [0x12] = &&op_0x12, [0x13] = &&op_0x13, [0x14] = &&op_0x14,
+            [0x15] = &&op_0x15, [0x16] = &&op_0x16, [0x17] = &&op_0x17, [0x19] = &&op_0x19,
+            [0x1a] = &&op_0x1a, [0x1b] = &&op_0x1b, [0x1c] = &&op_0x1c, [0x1d] = &&op_0x1d,
+            [0x1e] = &&op_0x1e, [0x1f] = &&op_0x1f,
+            [0x21] = &&op_0x21, [0x22] = &&op_0x22, [0x23] = &&op_0x23, [0x24] = &&op_0x24,
+            [0x25] = &&op_0x25, [0x26] = &&op_0x26, [0x29] = &&op_0x29, [0x2a] = &&op_0x2a,
+            [0x2b] = &&op_0x2b, [0x2c] = &&op_0x2c, [0x2d] = &&op_0x2d, [0x2e] = &&op_0x2e,
+            [0x2f] = &&op_0x2f,
+            [0x31] = &&op_0x31, [0x32] = &&op_0x32, [0x33] = &&op_0x33, [0x34] = &&op_0x34,
+            [0x35] = &&op_0x35, [0x36] = &&op_0x36, [0x37] = &&op_0x37, [0x39] = &&op_0x39,
+            [0x3a] = &&op_0x3a, [0x3b] = &&op_0x3b, [0x3c] = &&op_0x3c, [0x3d] = &&op_0x3d,
+            [0x3e] = &&op_0x3e, [0x3f] = &&op_0x3f,
+
+            [0x40] = &&op_0x40, [0x41] = &&op_0x41, [0x42] = &&op_0x42, [0x43] = &&op_0x43,
+            [0x44] = &&op_0x44, [0x45] = &&op_0x45, [0x46] = &&op_0x46, [0x47] = &&op_0x47,
+            [0x48] = &&op_0x48, [0x49] = &&op_0x49, [0x4a] = &&op_0x4a, [0x4b] = &&op_0x4b,
+            [0x4c] = &&op_0x4c, [0x4d] = &&op_0x4d, [0x4e] = &&op_0x4e, [0x4f] = &&op_0x4f,
+            [0x50] = &&op_0x50, [0x51] = &&op_0x51, [0x52] = &&op_0x52, [0x53] = &&op_0x53,
+            [0x54] = &&op_0x54, [0x55] = &&op_0x55, [0x56] = &&op_0x56, [0x57] = &&op_0x57,
+            [0x58] = &&op_0x58, [0x59] = &&op_0x59, [0x5a] = &&op_0x5a, [0x5b] = &&op_0x5b,
+            [0x5c] = &&op_0x5c, [0x5d] = &&op_0x5d, [0x5e] = &&op_0x5e, [0x5f] = &&op_0x5f,
+            [0x60] = &&op_0x60, [0x61] = &&op_0x61, [0x62] = &&op_0x62, [0x63] = &&op_0x63,
+            [0x64] = &&op_0x64, [0x65] = &&op_0x65, [0x66] = &&op_0x66, [0x67] = &&op_0x67,
+            [0x68] = &&op_0x68, [0x69] = &&op_0x69, [0x6a] = &&op_0x6a, [0x6b] = &&op_0x6b,
+            [0x6c] = &&op_0x6c, [0x6d] = &&op_0x6d, [0x6e] = &&op_0x6e, [0x6f] = &&op_0x6f,
+            [0x70] = &&op_0x70, [0x71] = &&op_0x71, [0x72] = &&op_0x72, [0x73] = &&op_0x73,
+            [0x74] = &&op_0x74, [0x75] = &&op_0x75, [0x76] = &&op_0x76, [0x77] = &&op_0x77,
+            [0x78] = &&op_0x78, [0x79] = &&op_0x79, [0x7a] = &&op_0x7a, [0x7b] = &&op_0x7b,
+            [0x7c] = &&op_0x7c, [0x7d] = &&op_0x7d, [0x7e] = &&op_0x7e, [0x7f] = &&op_0x7f,
+
+            [0x80] = &&op_0x80, [0x81] = &&op_0x81, [0x82] = &&op_0x82, [0x83] = &&op_0x83,
+            [0x84] = &&op_0x84, [0x85] = &&op_0x85, [0x86] = &&op_0x86, [0x87] = &&op_0x87,
+            [0x88] = &&op_0x88, [0x89] = &&op_0x89, [0x8a] = &&op_0x8a, [0x8b] = &&op_0x8b,
+            [0x8c] = &&op_0x8c, [0x8d] = &&op_0x8d, [0x8e] = &&op_0x8e, [0x8f] = &&op_0x8f,
+            [0x90] = &&op_0x90, [0x91] = &&op_0x91, [0x92] = &&op_0x92, [0x93] = &&op_0x93,
+            [0x94] = &&op_0x94, [0x95] = &&op_0x95, [0x96] = &&op_0x96, [0x97] = &&op_0x97,
+            [0x98] = &&op_0x98, [0x99] = &&op_0x99, [0x9a] = &&op_0x9a, [0x9b] = &&op_0x9b,
+            [0x9c] = &&op_0x9c, [0x9d] = &&op_0x9d, [0x9e] = &&op_0x9e, [0x9f] = &&op_0x9f,
+            [0xa0] = &&op_0xa0, [0xa1] = &&op_0xa1, [0xa2] = &&op_0xa2, [0xa3] = &&op_0xa3,
+            [0xa4] = &&op_0xa4, [0xa5] = &&op_0xa5, [0xa6] = &&op_0xa6, [0xa7] = &&op_0xa7,
+            [0xa8] = &&op_0xa8, [0xa9] = &&op_0xa9, [0xaa] = &&op_0xaa, [0xab] = &&op_0xab,
+            [0xac] = &&op_0xac, [0xad] = &&op_0xad, [0xae] = &&op_0xae, [0xaf] = &&op_0xaf,
+            [0xb0] = &&op_0xb0, [0xb1] = &&op_0xb1, [0xb2] = &&op_0xb2, [0xb3] = &&op_0xb3,
+            [0xb4] = &&op_0xb4, [0xb5] = &&op_0xb5, [0xb6] = &&op_0xb6, [0xb7] = &&op_0xb7,
+            [0xb8] = &&op_0xb8, [0xb9] = &&op_0xb9, [0xba] = &&op_0xba, [0xbb] = &&op_0xbb,
+            [0xbc] = &&op_0xbc, [0xbd] = &&op_0xbd, [0xbe] = &&op_0xbe, [0xbf] = &&op_0xbf,
+
+            [0xc0] = &&op_0xc0, [0xc1] = &&op_0xc1, [0xc2] = &&op_0xc2, [0xc3] = &&op_0xc3,
+            [0xc4] = &&op_0xc4, [0xc5] = &&op_0xc5, [0xc6] = &&op_0xc6, [0xc8] = &&op_0xc8,
+            [0xc9] = &&op_0xc9, [0xca] = &&op_0xca, [0xcc] = &&op_0xcc, [0xcd] = &&op_0xcd,
+            [0xce] = &&op_0xce,
+            [0xd0] = &&op_0xd0, [0xd1] = &&op_0xd1, [0xd2] = &&op_0xd2, [0xd3] = &&op_0xd3,
+            [0xd4] = &&op_0xd4, [0xd5] = &&op_0xd5, [0xd6] = &&op_0xd6, [0xd8] = &&op_0xd8,
+            [0xda] = &&op_0xda, [0xdb] = &&op_0xdb, [0xdc] = &&op_0xdc, [0xde] = &&op_0xde,
+            [0xe0] = &&op_0xe0, [0xe1] = &&op_0xe1, [0xe2] = &&op_0xe2, [0xe3] = &&op_0xe3,
+            [0xe4] = &&op_0xe4, [0xe5] = &&op_0xe5, [0xe6] = &&op_0xe6, [0xe8] = &&op_0xe8,
+            [0xe9] = &&op_0xe9, [0xea] = &&op_0xea, [0xeb] = &&op_0xeb, [0xec] = &&op_0xec,
+            [0xee] = &&op_0xee,
+            [0xf0] = &&op_0xf0, [0xf1] = &&op_0xf1, [0xf2] = &&op_0xf2, [0xf3] = &&op_0xf3,
+            [0xf4] = &&op_0xf4, [0xf5] = &&op_0xf5, [0xf6] = &&op_0xf6, [0xf8] = &&op_0xf8,
+            [0xf9] = &&op_0xf9, [0xfa] = &&op_0xfa, [0xfb] = &&op_0xfb, [0xfc] = &&op_0xfc,
+            [0xfe] = &&op_0xfe,
+
+            // undocumented aliases
+            [0x08] = &&op_0x00, [0x10] = &&op_0x00, [0x18] = &&op_0x00, [0x20] = &&op_0x00,
+            [0x28] = &&op_0x00, [0x30] = &&op_0x00, [0x38] = &&op_0x00,
+            [0xcb] = &&op_0xc3, [0xd9] = &&op_0xc9,
+            [0xdd] = &&op_0xcd, [0xed] = &&op_0xcd, [0xfd] = &&op_0xcd,
+
+            [0xc7] = &&op_rst, [0xcf] = &&op_rst, [0xd7] = &&op_rst, [0xdf] = &&op_rst,
+            [0xe7] = &&op_rst, [0xef] = &&op_rst, [0xf7] = &&op_rst, [0xff] = &&op_rst,
+
+            // pairs the block cache decodes into one micro-op
+            [256] = BLOCK_FUSIONS(FUSED_HANDLER)
+    };
+#pragma GCC diagnostic pop
+
+    uint8_t *memory = state->memory;
+    const uint8_t *opcode;
+    uint8_t a, b, c, d, e, h, l;
+    uint16_t sp, pc;
+    uint16_t w;
+    uint32_t sum;
+    uint8_t value, tmp;
+    uint64_t cycles;
+    long remaining = n_instructions;
+    int halted = 0;
+    ENGINE_LOCALS
+
+    RELOAD();
+    DISPATCH();
+
+    op_0x00: NEXT(1); // NOP
+    op_0x01: c = opcode[1]; b = opcode[2]; NEXT(3); // LXI B, D16
+    op_0x02: WRITE(WORD(b, c), a); NEXT(1); // STAX B
+    op_0x03: INX(b, c); NEXT(1); // INX B
+    op_0x04: INR(b); NEXT(1); // INR B
+    op_0x05: DCR(b); NEXT(1); // DCR B
+    op_0x06: b = opcode[1]; NEXT(2); // MVI B, D8
+    op_0x07: // RLC
+        tmp = (a & 0x80) != 0;
+        a = a << 1 | tmp;
+        FLAGS(state).cy = tmp;
+        NEXT(1);
+    op_0x09: DAD(WORD(b, c)); NEXT(1); // DAD B
+    op_0x0a: a = READ(WORD(b, c)); NEXT(1); // LDAX B
+    op_0x0b: DCX(b, c); NEXT(1); // DCX B
+    op_0x0c: INR(c); NEXT(1); // INR C
+    op_0x0d: DCR(c); NEXT(1); // DCR C
+    op_0x0e: c = opcode[1]; NEXT(2); // MVI C, D8
+    op_0x0f: // RRC
+        tmp = a & 0x1;
+        a = (a >> 1) | (tmp << 7);
+        FLAGS(state).cy = tmp;
+        NEXT(1);
+
+    op_0x11: e = opcode[1]; d = opcode[2]; NEXT(3); // LXI D, D16
+    op_0x12: WRITE(WORD(d, e), a); NEXT(1); // STAX D
+    op_0x13: INX(d, e); NEXT(1); // INX D
+    op_0x14: INR(d); NEXT(1); // INR D
+    op_0x15: DCR(d); NEXT(1); // DCR D
+    op_0x16: d = opcode[1]; NEXT(2); // MVI D, D8
+    op_0x17: // RAL
+        tmp = (a & 0x80) != 0;
+        a = a << 1 | FLAGS_READ(state).cy;
+        FLAGS(state).cy = tmp;
+        NEXT(1);
+    op_0x19: DAD(WORD(d, e)); NEXT(1); // DAD D
+    op_0x1a: a = READ(WORD(d, e)); NEXT(1); // LDAX D
+    op_0x1b: DCX(d, e); NEXT(1); // DCX D
+    op_0x1c: INR(e); NEXT(1); // INR E
+    op_0x1d: DCR(e); NEXT(1); // DCR E
+    op_0x1e: e = opcode[1]; NEXT(2); // MVI E, D8
+    op_0x1f: // RAR
+        tmp = a & 0x1;
+        a = (a >> 1) | (FLAGS_READ(state).cy << 7);
+        FLAGS(state).cy = tmp;
+        NEXT(1);
+
+    op_0x21: l = opcode[1]; h = opcode[2]; NEXT(3); // LXI H, D16
+    op_0x22: // SHLD adr
+        WRITE(IMM16, l);
+        WRITE(IMM16 + 1, h);
+        NEXT(3);
+    op_0x23: INX(h, l); NEXT(1); // INX H
+    op_0x24: INR(h); NEXT(1); // INR H
+    op_0x25: DCR(h); NEXT(1); // DCR H
+    op_0x26: h = opcode[1]; NEXT(2); // MVI H, D8
+    op_0x29: DAD(HL); NEXT(1); // DAD H
+    op_0x2a: // LHLD adr
+        l = READ(IMM16);
+        h = READ(IMM16 + 1);
+        NEXT(3);
+    op_0x2b: DCX(h, l); NEXT(1); // DCX H
+    op_0x2c: INR(l); NEXT(1); // INR L
+    op_0x2d: DCR(l); NEXT(1); // DCR L
+    op_0x2e: l = opcode[1]; NEXT(2); // MVI L, D8
+    op_0x2f: a = ~a; NEXT(1); // CMA
+
+    op_0x31: sp = IMM16; NEXT(3); // LXI SP, D16
+    op_0x32: WRITE(IMM16, a); NEXT(3); // STA adr
+    op_0x33: sp += 1; NEXT(1); // INX SP
+    op_0x34: // INR M
+        value = READ(HL) + 1;
+        WRITE(HL, value);
+        FLAGS_INR(state, value);
+        NEXT(1);
+    op_0x35: // DCR M
+        value = READ(HL) - 1;
+        WRITE(HL, value);
+        FLAGS_DCR(state, value);
+        NEXT(1);
+    op_0x36: WRITE(HL, opcode[1]); NEXT(2); // MVI M, D8
+    op_0x37: FLAGS(state).cy = 1; NEXT(1); // STC
+    op_0x39: DAD(sp); NEXT(1); // DAD SP
+    op_0x3a: a = READ(IMM16); NEXT(3); // LDA adr
+    op_0x3b: sp -= 1; NEXT(1); // DCX SP
+    op_0x3c: INR(a); NEXT(1); // INR A
+    op_0x3d: DCR(a); NEXT(1); // DCR A
+    op_0x3e: a = opcode[1]; NEXT(2); // MVI A, D8
+    op_0x3f: FLAGS(state).cy = !FLAGS(state).cy; NEXT(1); // CMC
+
+    op_0x40: NEXT(1); // MOV B, B
+    op_0x41: b = c; NEXT(1); // MOV B, C
+    op_0x42: b = d; NEXT(1); // MOV B, D
+    op_0x43: b = e; NEXT(1); // MOV B, E
+    op_0x44: b = h; NEXT(1); // MOV B, H
+    op_0x45: b = l; NEXT(1); // MOV B, L
+    op_0x46: b = READ(HL); NEXT(1); // MOV B, M
+    op_0x47: b = a; NEXT(1); // MOV B, A
+    op_0x48: c = b; NEXT(1); // MOV C, B
+    op_0x49: NEXT(1); // MOV C, C
+    op_0x4a: c = d; NEXT(1); // MOV C, D
+    op_0x4b: c = e; NEXT(1); // MOV C, E
+    op_0x4c: c = h; NEXT(1); // MOV C, H
+    op_0x4d: c = l; NEXT(1); // MOV C, L
+    op_0x4e: c = READ(HL); NEXT(1); // MOV C, M
+    op_0x4f: c = a; NEXT(1); // MOV C, A
+
+    op_0x50: d = b; NEXT(1); // MOV D, B
+    op_0x51: d = c; NEXT(1); // MOV D, C
+    op_0x52: NEXT(1); // MOV D, D
+    op_0x53: d = e; NEXT(1); // MOV D, E
+    op_0x54: d = h; NEXT(1); // MOV D, H
+    op_0x55: d = l; NEXT(1); // MOV D, L
+    op_0x56: d = READ(HL); NEXT(1); // MOV D, M
+    op_0x57: d = a; NEXT(1); // MOV D, A
+    op_0x58: e = b; NEXT(1); // MOV E, B
+    op_0x59: e = c; NEXT(1); // MOV E, C
+    op_0x5a: e = d; NEXT(1); // MOV E, D
+    op_0x5b: NEXT(1); // MOV E, E
+    op_0x5c: e = h; NEXT(1); // MOV E, H
+    op_0x5d: e = l; NEXT(1); // MOV E, L
+    op_0x5e: e = READ(HL); NEXT(1); // MOV E, M
+    op_0x5f: e = a; NEXT(1); // MOV E, A
+
+    op_0x60: h = b; NEXT(1); // MOV H, B
+    op_0x61: h = c; NEXT(1); // MOV H, C
+    op_0x62: h = d; NEXT(1); // MOV H, D
+    op_0x63: h = e; NEXT(1); // MOV H, E
+    op_0x64: NEXT(1); // MOV H, H
+    op_0x65: h = l; NEXT(1); // MOV H, L
+    op_0x66: h = READ(HL); NEXT(1); // MOV H, M
+    op_0x67: h = a; NEXT(1); // MOV H, A
+    op_0x68: l = b; NEXT(1); // MOV L, B
+    op_0x69: l = c; NEXT(1); // MOV L, C
+    op_0x6a: l = d; NEXT(1); // MOV L, D
+    op_0x6b: l = e; NEXT(1); // MOV L, E
+    op_0x6c: l = h; NEXT(1); // MOV L, H
+    op_0x6d: NEXT(1); // MOV L, L
+    op_0x6e: l = READ(HL); NEXT(1); // MOV L, M
+    op_0x6f: l = a; NEXT(1); // MOV L, A
+
+    op_0x70: WRITE(HL, b); NEXT(1); // MOV M, B
+    op_0x71: WRITE(HL, c); NEXT(1); // MOV M, C
+    op_0x72: WRITE(HL, d); NEXT(1); // MOV M, D
+    op_0x73: WRITE(HL, e); NEXT(1); // MOV M, E
+    op_0x74: WRITE(HL, h); NEXT(1); // MOV M, H
+    op_0x75: WRITE(HL, l); NEXT(1); // MOV M, L
+    op_0x76: halted = state->halted = 1; goto done; // HLT
+    op_0x77: WRITE(HL, a); NEXT(1); // MOV M, A
+    op_0x78: a = b; NEXT(1); // MOV A, B
+    op_0x79: a = c; NEXT(1); // MOV A, C
+    op_0x7a: a = d; NEXT(1); // MOV A, D
+    op_0x7b: a = e; NEXT(1); // MOV A, E
+    op_0x7c: a = h; NEXT(1); // MOV A, H
+    op_0x7d: a = l; NEXT(1); // MOV A, L
+    op_0x7e: a = READ(HL); NEXT(1); // MOV A, M
+    op_0x7f: NEXT(1); // MOV A, A
+
+    op_0x80: ADD(b); NEXT(1); // ADD B
+    op_0x81: ADD(c); NEXT(1); // ADD C
+    op_0x82: ADD(d); NEXT(1); // ADD D
+    op_0x83: ADD(e); NEXT(1); // ADD E
+    op_0x84: ADD(h); NEXT(1); // ADD H
+    op_0x85: ADD(l); NEXT(1); // ADD L
+    op_0x86: ADD(READ(HL)); NEXT(1); // ADD M
+    op_0x87: ADD(a); NEXT(1); // ADD A
+    op_0x88: ADC(b); NEXT(1); // ADC B
+    op_0x89: ADC(c); NEXT(1); // ADC C
+    op_0x8a: ADC(d); NEXT(1); // ADC D
+    op_0x8b: ADC(e); NEXT(1); // ADC E
+    op_0x8c: ADC(h); NEXT(1); // ADC H
+    op_0x8d: ADC(l); NEXT(1); // ADC L
+    op_0x8e: ADC(READ(HL)); NEXT(1); // ADC M
+    op_0x8f: ADC(a); NEXT(1); // ADC A
+
+    op_0x90: SUB(b); NEXT(1); // SUB B
+    op_0x91: SUB(c); NEXT(1); // SUB C
+    op_0x92: SUB(d); NEXT(1); // SUB D
+    op_0x93: SUB(e); NEXT(1); // SUB E
+    op_0x94: SUB(h); NEXT(1); // SUB H
+    op_0x95: SUB(l); NEXT(1); // SUB L
+    op_0x96: SUB(READ(HL)); NEXT(1); // SUB M
+    op_0x97: SUB(a); NEXT(1); // SUB A
+    op_0x98: SBB(b); NEXT(1); // SBB B
+    op_0x99: SBB(c); NEXT(1); // SBB C
+    op_0x9a: SBB(d); NEXT(1); // SBB D
+    op_0x9b: SBB(e); NEXT(1); // SBB E
+    op_0x9c: SBB(h); NEXT(1); // SBB H
+    op_0x9d: SBB(l); NEXT(1); // SBB L
+    op_0x9e: SBB(READ(HL)); NEXT(1); // SBB M
+    op_0x9f: SBB(a); NEXT(1); // SBB A
+
+    op_0xa0: ANA(b); NEXT(1); // ANA B
+    op_0xa1: ANA(c); NEXT(1); // ANA C
+    op_0xa2: ANA(d); NEXT(1); // ANA D
+    op_0xa3: ANA(e); NEXT(1); // ANA E
+    op_0xa4: ANA(h); NEXT(1); // ANA H
+    op_0xa5: ANA(l); NEXT(1); // ANA L
+    op_0xa6: ANA(READ(HL)); NEXT(1); // ANA M
+    op_0xa7: ANA(a); NEXT(1); // ANA A
+    op_0xa8: XRA(b); NEXT(1); // XRA B
+    op_0xa9: XRA(c); NEXT(1); // XRA C
+    op_0xaa: XRA(d); NEXT(1); // XRA D
+    op_0xab: XRA(e); NEXT(1); // XRA E
+    op_0xac: XRA(h); NEXT(1); // XRA H
+    op_0xad: XRA(l); NEXT(1); // XRA L
+    op_0xae: XRA(READ(HL)); NEXT(1); // XRA M
+    op_0xaf: XRA(a); NEXT(1); // XRA A
+
+    op_0xb0: ORA(b); NEXT(1); // ORA B
+    op_0xb1: ORA(c); NEXT(1); // ORA C
+    op_0xb2: ORA(d); NEXT(1); // ORA D
+    op_0xb3: ORA(e); NEXT(1); // ORA E
+    op_0xb4: ORA(h); NEXT(1); // ORA H
+    op_0xb5: ORA(l); NEXT(1); // ORA L
+    op_0xb6: ORA(READ(HL)); NEXT(1); // ORA M
+    op_0xb7: ORA(a); NEXT(1); // ORA A
+    op_0xb8: CMP(b); NEXT(1); // CMP B
+    op_0xb9: CMP(c); NEXT(1); // CMP C
+    op_0xba: CMP(d); NEXT(1); // CMP D
+    op_0xbb: CMP(e); NEXT(1); // CMP E
+    op_0xbc: CMP(h); NEXT(1); // CMP H
+    op_0xbd: CMP(l); NEXT(1); // CMP L
+    op_0xbe: CMP(READ(HL)); NEXT(1); // CMP M
+    op_0xbf: CMP(a); NEXT(1); // CMP A
+
+    op_0xc0: RET_IF(!FLAGS_READ(state).z); // RNZ
+    op_0xc1: POP(b, c); NEXT(1); // POP B
+    op_0xc2: JUMP_IF(!FLAGS_READ(state).z); // JNZ adr
+    op_0xc3: JUMP_IF(1); // JMP adr
+    op_0xc4: CALL_IF(!FLAGS_READ(state).z); // CNZ adr
+    op_0xc5: PUSH(b, c); NEXT(1); // PUSH B
+    op_0xc6: ADD(opcode[1]); NEXT(2); // ADI D8
+    op_0xc8: RET_IF(FLAGS_READ(state).z); // RZ
+    op_0xc9: RET(); // RET
+    op_0xca: JUMP_IF(FLAGS_READ(state).z); // JZ adr
+    op_0xcc: CALL_IF(FLAGS_READ(state).z); // CZ adr
+    op_0xcd: CALL(); // CALL adr
+    op_0xce: ADC(opcode[1]); NEXT(2); // ACI D8
+
+    op_0xd0: RET_IF(!FLAGS_READ(state).cy); // RNC
+
+    op_0xd1: POP(d, e); NEXT(1); // POP D
+    op_0xd2: JUMP_IF(!FLAGS_READ(state).cy); // JNC adr
+    op_0xd3: // OUT D8
+        state->a = a;
+        core8080_io_write(state, opcode[1]);
+        NEXT(2);
+    op_0xd4: CALL_IF(!FLAGS_READ(state).cy); // CNC adr
+    op_0xd5: PUSH(d, e); NEXT(1); // PUSH D
+    op_0xd6: SUB(opcode[1]); NEXT(2); // SUI D8
+    op_0xd8: RET_IF(FLAGS_READ(state).cy); // RC
+    op_0xda: JUMP_IF(FLAGS_READ(state).cy); // JC adr
+    op_0xdb: // IN D8
+        core8080_io_read(state, opcode[1]);
+        a = state->a;
+        NEXT(2);
+    op_0xdc: CALL_IF(FLAGS_READ(state).cy); // CC adr
+    op_0xde: SBB(opcode[1]); NEXT(2); // SBI D8
+
+    op_0xe0: RET_IF(!FLAGS_READ(state).p); // RPO
+    op_0xe1: POP(h, l); NEXT(1); // POP H
+    op_0xe2: JUMP_IF(!FLAGS_READ(state).p); // JPO adr
+    op_0xe3: // XTHL
+        POP(value, tmp);
+        PUSH(h, l);
+        h = value;
+        l = tmp;
+        NEXT(1);
+    op_0xe4: CALL_IF(!FLAGS_READ(state).p); // CPO adr
+    op_0xe5: PUSH(h, l); NEXT(1); // PUSH H
+    op_0xe6: ANA(opcode[1]); NEXT(2); // ANI D8
+    op_0xe8: RET_IF(FLAGS_READ(state).p); // RPE
+    op_0xe9: pc = HL; DISPATCH(); // PCHL
+    op_0xea: JUMP_IF(FLAGS_READ(state).p); // JPE adr
+    op_0xeb: // XCHG
+        value = h; h = d; d = value;
+        tmp = l; l = e; e = tmp;
+        NEXT(1);
+    op_0xec: CALL_IF(FLAGS_READ(state).p); // CPE adr
+    op_0xee: XRA(opcode[1]); NEXT(2); // XRI D8
+
+    op_0xf0: RET_IF(!FLAGS_READ(state).s); // RP
+    op_0xf1: // POP PSW
+        POP(a, tmp);
+        unpack_flags(state, tmp);
+        NEXT(1);
+    op_0xf2: JUMP_IF(!FLAGS_READ(state).s); // JP adr
+    op_0xf3: state->int_enable = 0; NEXT(1); // DI
+    op_0xf4: CALL_IF(!FLAGS_READ(state).s); // CP adr
+    op_0xf5: PUSH(a, pack_flags(state)); NEXT(1); // PUSH PSW
+    op_0xf6: ORA(opcode[1]); NEXT(2); // ORI D8
+    op_0xf8: RET_IF(FLAGS_READ(state).s); // RM
+    op_0xf9: sp = HL; NEXT(1); // SPHL
+    op_0xfa: JUMP_IF(FLAGS_READ(state).s); // JM adr
+    op_0xfb: state->int_enable = 1; NEXT(1); // EI
+    op_0xfc: CALL_IF(FLAGS_READ(state).s); // CM adr
+    op_0xfe: CMP(opcode[1]); NEXT(2); // CPI D8
+
+    op_rst: // RST n
+        w = pc + 1;
+        pc = opcode[0] & 0x38;
+        PUSH(w >> 8, w & 0xff);
+        DISPATCH();
+
+    // first half, then FUSE takes the second micro-op the way a dispatch would, budget check
+    // included, and the second half runs without the indirect jump
+    fuse_dcr_b_jnz: DCR(b); FUSE(1); JUMP_IF(!FLAGS_READ(state).z);
+    fuse_dcr_c_jnz: DCR(c); FUSE(1); JUMP_IF(!FLAGS_READ(state).z);
+    fuse_dcr_d_jnz: DCR(d); FUSE(1); JUMP_IF(!FLAGS_READ(state).z);
+    fuse_dcr_e_jnz: DCR(e); FUSE(1); JUMP_IF(!FLAGS_READ(state).z);
+    fuse_dcr_a_jnz: DCR(a); FUSE(1); JUMP_IF(!FLAGS_READ(state).z);
+    fuse_cpi_jz: CMP(opcode[1]); FUSE(2); JUMP_IF(FLAGS_READ(state).z);
+    fuse_cpi_jnz: CMP(opcode[1]); FUSE(2); JUMP_IF(!FLAGS_READ(state).z);
+    fuse_cpi_jc: CMP(opcode[1]); FUSE(2); JUMP_IF(FLAGS_READ(state).cy);
+    fuse_cpi_jnc: CMP(opcode[1]); FUSE(2); JUMP_IF(!FLAGS_READ(state).cy);
+    fuse_ana_a_jz: ANA(a); FUSE(1); JUMP_IF(FLAGS_READ(state).z);
+    fuse_ana_a_jnz: ANA(a); FUSE(1); JUMP_IF(!FLAGS_READ(state).z);
+    fuse_ora_a_jz: ORA(a); FUSE(1); JUMP_IF(FLAGS_READ(state).z);
+    fuse_ora_a_jnz: ORA(a); FUSE(1); JUMP_IF(!FLAGS_READ(state).z);
+    fuse_lda_ana_a: a = READ(IMM16); FUSE(3); ANA(a); NEXT(1);
+    fuse_mov_a_m_inx_h: a = READ(HL); FUSE(1); INX(h, l); NEXT(1);
+    fuse_mov_m_a_inx_h: WRITE(HL, a); FUSE(1); INX(h, l); NEXT(1);
+    fuse_mvi_m_inx_h: WRITE(HL, opcode[1]); FUSE(2); INX(h, l); NEXT(1);
+    fuse_ldax_d_mov_m_a: a = READ(WORD(d, e)); FUSE(1); WRITE(HL, a); NEXT(1);
+    fuse_mov_a_l_ani: a = l; FUSE(1); ANA(opcode[1]); NEXT(2);
+    fuse_mov_a_h_cpi: a = h; FUSE(1); CMP(opcode[1]); NEXT(2);
+
+    op_fallback:
+        // anything without a handler of its own goes through the switch interpreter,
+        // which does its own cycle accounting
+        cycles -= cycles_8080[opcode[0]];
+        SPILL();
+        halted = cpu_update(state);
+        RELOAD();
+        RESYNC();
+        if (halted) goto done;
+        DISPATCH();
+
+    done:
+    SPILL();
+    return halted;
+}
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace8080.h"
+#include "core8080.h"
+
+static struct trace_8080 *map_trace(int fd, size_t size, int prot) {
+    void *mapping = mmap(NULL, size, prot, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return NULL;
+
+    struct trace_8080 *trace = calloc(1, sizeof(struct trace_8080));
+    trace->header = mapping;
+    trace->records = (struct trace_record_8080 *) (trace->header + 1);
+    trace->size = size;
+    return trace;
+}
+
+struct trace_8080 *make_trace(const char *path, uint64_t capacity) {
+    size_t size = sizeof(struct trace_header_8080) + capacity * sizeof(struct trace_record_8080);
+    int fd;
+
+    if (capacity == 0 || (capacity & (capacity - 1))) return NULL;
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, size)) {
+        close(fd);
+        return NULL;
+    }
+
+    struct trace_8080 *trace = map_trace(fd, size, PROT_READ | PROT_WRITE);
+    if (trace == NULL) return NULL;
+
+    memcpy(trace->header->magic, TRACE_MAGIC, sizeof(trace->header->magic));
+    trace->header->version = TRACE_VERSION;
+    trace->header->record_size = sizeof(struct trace_record_8080);
+    trace->header->capacity = capacity;
+    atomic_store(&trace->header->head, 0);
+    trace->mask = capacity - 1;
+    return trace;
+}
+
+struct trace_8080 *open_trace(const char *path) {
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) return NULL;
+    if (fstat(fd, &info) || info.st_size < (off_t) sizeof(struct trace_header_8080)) {
+        close(fd);
+        return NULL;
+    }
+
+    struct trace_8080 *trace = map_trace(fd, info.st_size, PROT_READ);
+    if (trace == NULL) return NULL;
+
+    // capacity comes from the file, it has to be one make_trace could have written and the
+    // records it promises have to be in the file
+    struct trace_header_8080 *header = trace->header;
+    uint64_t capacity = header->capacity;
+    uint64_t fits = (trace->size - sizeof(struct trace_header_8080)) / sizeof(struct trace_record_8080);
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) || header->version != TRACE_VERSION ||
+        header->record_size != sizeof(struct trace_record_8080) || capacity == 0 || (capacity & (capacity - 1)) ||
+        capacity > fits) {
+        free_trace(trace);
+        return NULL;
+    }
+    trace->head = atomic_load_explicit(&header->head, memory_order_acquire);
+    trace->mask = capacity - 1;
+    return trace;
+}
+
+void trace8080_record(struct trace_8080 *trace, struct state_8080 *state) {
+    struct trace_record_8080 *record = trace8080_next(trace);
+    uint8_t *opcode = &state->memory[state->pc];
+
+    record->cycle = state->cycles;
+    record->pc = state->pc;
+    record->sp = state->sp;
+    record->bytes[0] = opcode[0];
+    record->bytes[1] = opcode[1];
+    record->bytes[2] = opcode[2];
+    record->a = state->a;
+    record->b = state->b;
+    record->c = state->c;
+    record->d = state->d;
+    record->e = state->e;
+    record->h = state->h;
+    record->l = state->l;
+    record->psw = pack_flags(state);
+    trace8080_commit(trace);
+}
+
+void free_trace(struct trace_8080 *trace) {
+    munmap(trace->header, trace->size);
+    free(trace);
+}
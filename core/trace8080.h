@@ -0,0 +1,66 @@
+#ifndef EMULATOR101_TRACE8080_H
+#define EMULATOR101_TRACE8080_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define TRACE_MAGIC "trace80"
+#define TRACE_VERSION 1
+#define TRACE_DEFAULT_RECORDS (1 << 22) // 96mb, must be a power of two
+
+// machine state right before the instruction at pc executed
+struct trace_record_8080 {
+    uint64_t cycle;
+    uint16_t pc;
+    uint16_t sp;
+    uint8_t bytes[3]; // opcode and the two bytes after it, enough to disassemble offline
+    uint8_t a, b, c, d, e, h, l;
+    uint8_t psw; // flags as PUSH PSW stores them
+    uint8_t pad;
+};
+
+// start of the trace file, the records follow it.
+// head counts every record ever written, the newest capacity of them are in the ring
+struct trace_header_8080 {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    _Atomic uint64_t head;
+    uint8_t pad[32];
+};
+
+// a trace file mapped into memory, written by one thread while others may read it live
+struct trace_8080 {
+    struct trace_header_8080 *header;
+    struct trace_record_8080 *records;
+    uint64_t head; // the writer's copy, published to header->head after each record
+    uint64_t mask;
+    size_t size;
+};
+
+struct state_8080;
+
+// creates (or truncates) path and maps it. returns NULL on failure
+struct trace_8080 *make_trace(const char *path, uint64_t capacity);
+
+// maps an existing trace read only, for decoders
+struct trace_8080 *open_trace(const char *path);
+
+void free_trace(struct trace_8080 *trace);
+
+static inline struct trace_record_8080 *trace8080_next(struct trace_8080 *trace) {
+    return &trace->records[trace->head & trace->mask];
+}
+
+// appends the state as it is before the instruction at state->pc
+void trace8080_record(struct trace_8080 *trace, struct state_8080 *state);
+
+// release so a live reader that sees the new head also sees the record
+static inline void trace8080_commit(struct trace_8080 *trace) {
+    trace->head += 1;
+    atomic_store_explicit(&trace->header->head, trace->head, memory_order_release);
+}
+
+#endif //EMULATOR101_TRACE8080_H
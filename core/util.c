@@ -23,4 +23,12 @@ int parity(int x, int size) {
         x = x >> 1;
     }
     return ((p & 0x1) == 0);
+}
+
+uint64_t hash_bytes(const uint8_t *bytes, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+    return hash;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <stddef.h>
 
 uint16_t make_word(uint8_t hb, uint8_t lb);
 
@@ -6,4 +7,7 @@ uint8_t get_low_byte(uint16_t word);
 
 uint8_t get_high_byte(uint16_t word);
 
-int parity(int x, int size);
\ No newline at end of file
+int parity(int x, int size);
+
+// 64 bit fnv-1a, for comparing memory and frames across runs
+uint64_t hash_bytes(const uint8_t *bytes, size_t length);
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "video8080.h"
+#include "core8080.h"
+#include "sched8080.h"
+#include "frame8080.h"
+
+// pixels are stored as r, g, b, a bytes, read here as little endian words
+#define PIXEL(r, g, b) ((uint32_t) (r) | (uint32_t) (g) << 8 | (uint32_t) (b) << 16 | 0xff000000u)
+#define BLACK PIXEL(0, 0, 0)
+#define WHITE PIXEL(255, 255, 255)
+#define GREEN PIXEL(0, 255, 0)
+#define RED PIXEL(255, 0, 0)
+
+// the cellophane overlay of the cabinet, one color per output column for every vram x.
+// only the bottom strip (x < 16) changes color along the row, everything else is a solid band
+enum overlay_band {
+    BAND_BOTTOM,
+    BAND_GREEN,
+    BAND_RED,
+    BAND_WHITE,
+};
+static uint32_t overlay_columns[4][SCREEN_WIDTH];
+static const uint32_t *overlay[SCREEN_HEIGHT];
+
+// 8 lit/unlit lane masks per vram bit pattern
+#define E(n) { \
+        0u - ((n) & 1), 0u - ((n) >> 1 & 1), 0u - ((n) >> 2 & 1), 0u - ((n) >> 3 & 1), \
+        0u - ((n) >> 4 & 1), 0u - ((n) >> 5 & 1), 0u - ((n) >> 6 & 1), 0u - ((n) >> 7 & 1) \
+    }
+#define E4(n) E(n), E((n) + 1), E((n) + 2), E((n) + 3)
+#define E16(n) E4(n), E4((n) + 4), E4((n) + 8), E4((n) + 12)
+#define E64(n) E16(n), E16((n) + 16), E16((n) + 32), E16((n) + 48)
+
+static const uint32_t expand[256][8] = {
+        E64(0), E64(64), E64(128), E64(192)
+};
+
+// transposes an 8x8 bit matrix held one row per byte (hacker's delight 7-3)
+static uint64_t transpose8(uint64_t x) {
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+// the screen is rotated 90 degrees anti-clockwise, so an 8x8 tile of vram (8 bytes stacked
+// over 8 scanlines) turns into 8 output rows of 8 pixels. transposing the tile gives one byte
+// per output row, which then expands into 8 contiguous pixels
+static uint64_t load_tile(const uint8_t *memory, int tile_y, int tile_x) {
+    const uint8_t *vram = &memory[VRAM_ADDRESS + tile_y * 8 * 32 + tile_x];
+    uint64_t tile = 0;
+    for (int k = 0; k < 8; k++) {
+        tile |= (uint64_t) vram[k * 32] << (8 * k);
+    }
+    return transpose8(tile);
+}
+
+static void draw_tile_scalar(const uint8_t *memory, struct frame_8080 *frame, int tile_y, int tile_x) {
+    uint64_t tile = load_tile(memory, tile_y, tile_x);
+
+    for (int bit = 0; bit < 8; bit++) {
+        const int x = tile_x * 8 + bit;
+        const uint32_t *lit = expand[(tile >> (8 * bit)) & 0xff];
+        const uint32_t *colors = overlay[x] + tile_y * 8;
+        uint32_t pixels[8];
+
+        for (int k = 0; k < 8; k++) {
+            pixels[k] = (lit[k] & colors[k]) | BLACK;
+        }
+        memcpy(frame->pixels[SCREEN_HEIGHT - 1 - x][tile_y * 8], pixels, sizeof(pixels));
+    }
+}
+
+static void (*draw_tile)(const uint8_t *memory, struct frame_8080 *frame, int tile_y, int tile_x) = draw_tile_scalar;
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static void draw_tile_avx2(const uint8_t *memory, struct frame_8080 *frame, int tile_y, int tile_x) {
+    const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i black = _mm256_set1_epi32((int) BLACK);
+    uint64_t tile = load_tile(memory, tile_y, tile_x);
+
+    for (int bit = 0; bit < 8; bit++) {
+        const int x = tile_x * 8 + bit;
+        __m256i row = _mm256_set1_epi32((int) ((tile >> (8 * bit)) & 0xff));
+        __m256i lit = _mm256_cmpeq_epi32(_mm256_and_si256(row, lanes), lanes);
+        __m256i colors = _mm256_loadu_si256((const __m256i *) (overlay[x] + tile_y * 8));
+        __m256i pixels = _mm256_or_si256(_mm256_and_si256(lit, colors), black);
+        _mm256_store_si256((__m256i *) frame->pixels[SCREEN_HEIGHT - 1 - x][tile_y * 8], pixels);
+    }
+}
+#endif
+
+static int rasterizer_ready = 0;
+
+#if defined(__GNUC__)
+__attribute__((constructor))
+#endif
+static void init_rasterizer(void) {
+    for (int column = 0; column < SCREEN_WIDTH; column++) {
+        overlay_columns[BAND_BOTTOM][column] = (column < 16 || column > 118 + 16) ? WHITE : GREEN;
+        overlay_columns[BAND_GREEN][column] = GREEN;
+        overlay_columns[BAND_RED][column] = RED;
+        overlay_columns[BAND_WHITE][column] = WHITE;
+    }
+    for (int x = 0; x < SCREEN_HEIGHT; x++) {
+        if (x < 16) overlay[x] = overlay_columns[BAND_BOTTOM];
+        else if (x <= 16 + 56) overlay[x] = overlay_columns[BAND_GREEN];
+        else if (x >= 16 + 56 + 120 && x < 16 + 56 + 120 + 32) overlay[x] = overlay_columns[BAND_RED];
+        else overlay[x] = overlay_columns[BAND_WHITE];
+    }
+
+#if defined(__GNUC__) && defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) draw_tile = draw_tile_avx2;
+#endif
+    rasterizer_ready = 1;
+}
+
+int gpu_update(struct state_8080 *state) {
+    struct frame_store_8080 *store = state->frames;
+    if (!rasterizer_ready) init_rasterizer();
+
+    if (!store) {
+        memset(state->vram_dirty, 0, sizeof(state->vram_dirty));
+        return 0;
+    }
+
+    // every buffer collects the tiles it missed, the back buffer only redraws its own
+    for (int i = 0; i < FRAME_BUFFERS; i++) {
+        for (int tile_y = 0; tile_y < SCREEN_WIDTH / 8; tile_y++) {
+            store->buffers[i]->stale[tile_y] |= state->vram_dirty[tile_y];
+        }
+    }
+    memset(state->vram_dirty, 0, sizeof(state->vram_dirty));
+
+    struct frame_8080 *frame = frame8080_back(store);
+    for (int tile_y = 0; tile_y < SCREEN_WIDTH / 8; tile_y++) {
+        uint32_t columns = frame->stale[tile_y];
+        frame->stale[tile_y] = 0;
+
+        while (columns) {
+            draw_tile(state->memory, frame, tile_y, __builtin_ctz(columns));
+            columns &= columns - 1;
+        }
+    }
+    frame8080_publish(store);
+
+    if (state->update_screen) state->update_screen(state);
+    return 0;
+}
+
+static void mid_screen(struct state_8080 *state, void *context) {
+    (void) context;
+    cpu_interrupt(state, 1);
+}
+
+static void vblank(struct state_8080 *state, void *context) {
+    (void) context;
+    cpu_interrupt(state, 2);
+}
+
+void video8080_install_interrupts(struct scheduler_8080 *sched, struct state_8080 *state) {
+    sched8080_add(sched, state->cycles + CYCLES_PER_FRAME / 2, CYCLES_PER_FRAME, mid_screen, NULL);
+    sched8080_add(sched, state->cycles + CYCLES_PER_FRAME, CYCLES_PER_FRAME, vblank, NULL);
+}
@@ -0,0 +1,15 @@
+#ifndef EMULATOR101_VIDEO8080_H
+#define EMULATOR101_VIDEO8080_H
+
+struct state_8080;
+struct scheduler_8080;
+
+// redraws the vram tiles written since the last call into the back buffer of state->frames,
+// publishes it and hands it to state->update_screen
+int gpu_update(struct state_8080 *state);
+
+// space invaders' video hardware raises RST 1 when the beam reaches the middle of the screen
+// and RST 2 on vblank, once per frame each
+void video8080_install_interrupts(struct scheduler_8080 *sched, struct state_8080 *state);
+
+#endif //EMULATOR101_VIDEO8080_H
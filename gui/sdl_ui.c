@@ -1,5 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
 
 #include <SDL2/SDL.h>
 
@@ -7,9 +9,283 @@
 #include "sdl_ui.h"
 
 #include "../core/core8080.h"
+#include "../core/io8080.h"
+#include "../core/sched8080.h"
+#include "../core/video8080.h"
+#include "../core/frame8080.h"
+#include "../core/input8080.h"
+#include "../core/trace8080.h"
+#include "../core/profile8080.h"
+#include "../core/jit8080.h"
+#include "../core/block8080.h"
+#include "../core/recomp8080.h"
+#include "../core/rom8080.h"
+#include "../core/shift8080.h"
 #include "../core/disassembler.h"
 
-int run_gui(char *filename, int debug) {
-    printf("Loaded Into gui Mode\n");
+// space invaders input port 1
+#define INPUT_COIN 0x01
+#define INPUT_P2_START 0x02
+#define INPUT_P1_START 0x04
+#define INPUT_ALWAYS_SET 0x08
+#define INPUT_FIRE 0x10
+#define INPUT_LEFT 0x20
+#define INPUT_RIGHT 0x40
+
+static const struct {
+    SDL_Scancode key;
+    struct input_event_8080 event;
+} keymap[] = {
+        {SDL_SCANCODE_C,      {1, INPUT_COIN, 0}},
+        {SDL_SCANCODE_1,      {1, INPUT_P1_START, 0}},
+        {SDL_SCANCODE_RETURN, {1, INPUT_P1_START, 0}},
+        {SDL_SCANCODE_2,      {1, INPUT_P2_START, 0}},
+        {SDL_SCANCODE_SPACE,  {1, INPUT_FIRE, 0}},
+        {SDL_SCANCODE_LEFT,   {1, INPUT_LEFT, 0}},
+        {SDL_SCANCODE_RIGHT,  {1, INPUT_RIGHT, 0}},
+};
+
+// everything the emulation thread owns, the render thread only touches the atomics and the
+// producer side of input
+struct emulation {
+    struct state_8080 *state;
+    struct scheduler_8080 *sched;
+    struct input_queue_8080 *input;
+    struct shift_register_8080 shifter;
+    atomic_int running;
+    atomic_uint emulation_us; // cpu and rasterizer time of the last frame
+};
+
+static struct frame_timing timing;
+
+const struct frame_timing *gui_frame_timing() {
+    return &timing;
+}
+
+static double elapsed_ms(uint64_t from, uint64_t to, uint64_t frequency) {
+    return (double) (to - from) * 1000.0 / (double) frequency;
+}
+
+// sleeps until slack ticks before deadline and returns the deadline of the next period.
+// after a stall (window dragged, machine suspended) it starts over instead of running
+// periods back to back to catch up
+static uint64_t pace(uint64_t deadline, uint64_t period, uint64_t slack, uint64_t frequency) {
+    uint64_t now = SDL_GetPerformanceCounter();
+    if (now + slack < deadline) {
+        SDL_Delay((uint32_t) ((deadline - slack - now) * 1000 / frequency));
+        now = SDL_GetPerformanceCounter();
+    }
+    return now > deadline + period ? now + period : deadline + period;
+}
+
+// emulation thread: one frame of cycles per period on its own clock, so presenting never
+// stalls the cpu and the cpu never waits for vsync
+static int emulate(void *data) {
+    struct emulation *emu = data;
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t period = frequency / FPS;
+    uint64_t deadline = SDL_GetPerformanceCounter() + period;
+
+    while (atomic_load(&emu->running)) {
+        uint64_t start = SDL_GetPerformanceCounter();
+
+        input8080_apply(emu->input, emu->state);
+        if (cpu_run_scheduled(emu->state, emu->sched, CYCLES_PER_FRAME)) {
+            printf("cpu halted with interrupts disabled at %x\n", emu->state->pc);
+            atomic_store(&emu->running, 0);
+        }
+        gpu_update(emu->state);
+
+        atomic_store(&emu->emulation_us, (unsigned) (elapsed_ms(start, SDL_GetPerformanceCounter(), frequency) * 1000));
+        deadline = pace(deadline, period, 0, frequency);
+    }
+    return 0;
+}
+
+// copies the frame into the streaming texture with a single lock,
+// one memcpy when the driver hands out a tightly packed buffer
+static void upload_frame(SDL_Texture *texture, const struct frame_8080 *frame) {
+    void *pixels;
+    int pitch;
+
+    if (SDL_LockTexture(texture, NULL, &pixels, &pitch) != 0) return;
+    if (pitch == sizeof(frame->pixels[0])) {
+        memcpy(pixels, frame->pixels, sizeof(frame->pixels));
+    } else {
+        for (int y = 0; y < SCREEN_HEIGHT; y++) {
+            memcpy((uint8_t *) pixels + y * pitch, frame->pixels[y], sizeof(frame->pixels[y]));
+        }
+    }
+    SDL_UnlockTexture(texture);
+}
+
+static void queue_key(struct input_queue_8080 *input, SDL_Scancode key, int pressed) {
+    for (size_t i = 0; i < sizeof(keymap) / sizeof(keymap[0]); i++) {
+        if (keymap[i].key != key) continue;
+
+        struct input_event_8080 event = keymap[i].event;
+        event.pressed = pressed;
+        input8080_push(input, event);
+    }
+}
+
+// whatever of the window was created, and SDL itself
+static void close_window(SDL_Window *window, SDL_Renderer *renderer, SDL_Texture *texture) {
+    if (texture) SDL_DestroyTexture(texture);
+    if (renderer) SDL_DestroyRenderer(renderer);
+    if (window) SDL_DestroyWindow(window);
+    SDL_Quit();
+}
+
+static void free_emulation(struct emulation *emu) {
+    if (emu->state->profile) free(emu->state->profile);
+    if (emu->state->trace) free_trace(emu->state->trace);
+    if (emu->state->jit) free_jit(emu->state->jit);
+    if (emu->state->blocks) free_block_cache(emu->state->blocks);
+    if (emu->state->recomp) free_recomp(emu->state->recomp);
+    free(emu->input);
+    free(emu->sched);
+    free_frame_store(emu->state->frames);
+    free_io(emu->state->io);
+    free_state(emu->state);
+}
+
+int run_gui(char *filename, int debug, char *trace_file, int profile, int jit, int blocks) {
+    struct emulation emu;
+
+    emu.state = make_state(0x10000, 0);
+    if (load_rom(emu.state, filename)) {
+        printf("Cannot Load ROM %s\n", filename);
+        free_state(emu.state);
+        return 1;
+    }
+    memory8080_invaders(emu.state);
+    emu.state->log_access = memory8080_print_access;
+
+    emu.state->io = make_io(256);
+    shift8080_install(emu.state->io, &emu.shifter);
+    io8080_write_port(emu.state->io, 1, INPUT_ALWAYS_SET);
+    emu.state->frames = make_frame_store();
+    if (trace_file) {
+        emu.state->trace = make_trace(trace_file, TRACE_DEFAULT_RECORDS);
+        if (emu.state->trace == NULL) printf("Cannot Create Trace %s\n", trace_file);
+    }
+    if (profile) emu.state->profile = make_profile();
+    if (jit) {
+        emu.state->jit = make_jit();
+        if (emu.state->jit == NULL) printf("No JIT On This Host, Interpreting\n");
+    }
+    if (blocks) emu.state->blocks = make_block_cache();
+    emu.state->recomp = make_recomp(emu.state->memory);
+
+    emu.sched = make_scheduler();
+    video8080_install_interrupts(emu.sched, emu.state);
+    emu.input = make_input_queue();
+    atomic_init(&emu.running, 1);
+    atomic_init(&emu.emulation_us, 0);
+
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0) {
+        printf("Cannot Initialize SDL: %s\n", SDL_GetError());
+        free_emulation(&emu);
+        return 1;
+    }
+
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    SDL_Window *window = SDL_CreateWindow("emulator101", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                          SCREEN_WIDTH * WINDOW_SCALE, SCREEN_HEIGHT * WINDOW_SCALE,
+                                          SDL_WINDOW_RESIZABLE);
+    SDL_Renderer *renderer = NULL;
+    if (window) renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if (window && renderer == NULL) renderer = SDL_CreateRenderer(window, -1, 0);
+    if (renderer) SDL_RenderSetLogicalSize(renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    // the frame store keeps r, g, b, a bytes, which is RGBA32 on either endianness
+    SDL_Texture *texture = NULL;
+    if (renderer) {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
+                                    SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+
+    // SDL wants events and rendering on the main thread, so the cpu is the one that moves
+    SDL_Thread *emulation_thread = NULL;
+    if (texture) emulation_thread = SDL_CreateThread(emulate, "emulation", &emu);
+    if (emulation_thread == NULL) {
+        printf("Cannot Open The Window: %s\n", SDL_GetError());
+        close_window(window, renderer, texture);
+        free_emulation(&emu);
+        return 1;
+    }
+
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t period = frequency / FPS;
+    uint64_t deadline = SDL_GetPerformanceCounter() + period;
+    uint64_t previous = SDL_GetPerformanceCounter();
+    uint64_t second_start = previous, second_frames = 0, shown = UINT64_MAX;
+    double second_total = 0, second_worst = 0;
+
+    memset(&timing, 0, sizeof(timing));
+
+    while (atomic_load(&emu.running)) {
+        SDL_Event event;
+
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) atomic_store(&emu.running, 0);
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) atomic_store(&emu.running, 0);
+            if ((event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) && !event.key.repeat) {
+                queue_key(emu.input, event.key.keysym.scancode, event.type == SDL_KEYDOWN);
+            }
+        }
+
+        const struct frame_8080 *frame = frame8080_acquire(emu.state->frames);
+        if (frame->number != shown) {
+            upload_frame(texture, frame);
+            shown = frame->number;
+        }
+
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, texture, NULL, NULL);
+        SDL_RenderPresent(renderer);
+
+        // vsync paces a 60hz display on its own. when the display runs faster or vsync is not
+        // available, sleep off what is left of the period. the last millisecond is left to
+        // vsync so SDL_Delay oversleeping never costs a whole refresh
+        deadline = pace(deadline, period, frequency / 1000, frequency);
+
+        uint64_t now = SDL_GetPerformanceCounter();
+        timing.last = elapsed_ms(previous, now, frequency);
+        timing.emulation = atomic_load(&emu.emulation_us) / 1000.0;
+        timing.frames += 1;
+        if (timing.last > 1000.0 / FPS * FRAME_DROP_THRESHOLD) timing.dropped += 1;
+        previous = now;
+
+        second_total += timing.last;
+        second_frames += 1;
+        if (timing.last > second_worst) second_worst = timing.last;
+        if (now - second_start >= frequency) {
+            char title[128];
+
+            timing.average = second_total / second_frames;
+            timing.worst = second_worst;
+            snprintf(title, sizeof(title), "emulator101 - %.1f fps, %.2f ms avg, %.2f ms worst",
+                     1000.0 / timing.average, timing.average, timing.worst);
+            SDL_SetWindowTitle(window, title);
+            if (debug) {
+                printf("%s, %.2f ms emulation, %lu dropped\n", title, timing.emulation,
+                       (unsigned long) timing.dropped);
+            }
+            second_start = now;
+            second_frames = 0;
+            second_total = 0;
+            second_worst = 0;
+        }
+    }
+
+    SDL_WaitThread(emulation_thread, NULL);
+    printf("%lu frames, %lu dropped\n", (unsigned long) timing.frames, (unsigned long) timing.dropped);
+
+    close_window(window, renderer, texture);
+
+    if (emu.state->profile) profile8080_report(stdout, emu.state->profile, emu.state->memory);
+    free_emulation(&emu);
     return 0;
-}
\ No newline at end of file
+}
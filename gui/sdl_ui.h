@@ -4,10 +4,24 @@
 
 #include <SDL2/SDL.h>
 
-#define SCREEN_WIDTH 640
-#define SCREEN_HEIGHT 480
+#define WINDOW_SCALE 2
+
+// frames slower than this many periods count as dropped
+#define FRAME_DROP_THRESHOLD 1.5
 
 struct state_8080;
 struct io_8080;
 
-int run_gui(char *filename, int debug);
\ No newline at end of file
+// wall clock times of the presentation loop in milliseconds, updated by the render thread once per frame
+struct frame_timing {
+    double last; // whole frame, present and pacing included
+    double average; // over the last second
+    double worst; // over the last second
+    double emulation; // cpu and rasterizer time of the last frame on the emulation thread
+    uint64_t frames;
+    uint64_t dropped;
+};
+
+int run_gui(char *filename, int debug, char *trace_file, int profile, int jit, int blocks);
+
+const struct frame_timing *gui_frame_timing();
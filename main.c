@@ -4,23 +4,36 @@
 #include <gui/sdl_ui.h>
 
 #include "cli/cli.h"
+#include "server/server.h"
+#include "batch/batch.h"
 
 enum MODE {
     MODE_CLI = 0,
     MODE_GUI = 1,
     MODE_SERVER = 2,
+    MODE_BATCH = 3,
 };
 struct arguments {
     int debug;
     int mode;
 
     char *target;
+    char *socket;
+    char *trace;
+    int profile;
+    int jit;
+    int blocks;
 };
 
 static struct argp_option options[] = {
         {"debug",  'd', 0,           0, "Print Debug Output"},
-        {"target", 't', "FILE_NAME", 0, "Binary File The Emulator Will Execute"},
+        {"target", 't', "FILE_NAME", 0, "Binary File The Emulator Will Execute, Or The Job List In Batch Mode"},
         {"mode",    'm', "MODE",  0, "Sets The Mod Of Execution For This Program"},
+        {"socket", 's', "SOCKET_PATH", 0, "Unix Socket The Server Mode Listens On"},
+        {"trace",  'r', "TRACE_FILE", 0, "Record A Binary Execution Trace, Read It With tracedump"},
+        {"profile", 'p', 0,           0, "Count Executions Per Address And Opcode, Print The Hot Spots On Exit"},
+        {"jit",    'j', 0,           0, "Translate The Program To Host Code Where Supported (GUI And Batch Modes)"},
+        {"blocks", 'b', 0,           0, "Run From Pre-Decoded Blocks Instead Of Fetching Every Instruction (GUI And Batch Modes)"},
         {0}
 };
 
@@ -34,6 +47,21 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
         case 't': // target file
             arguments->target = arg;
             break;
+        case 's': // server socket
+            arguments->socket = arg;
+            break;
+        case 'r': // trace file
+            arguments->trace = arg;
+            break;
+        case 'p': // profiler enabled
+            arguments->profile = 1;
+            break;
+        case 'j': // jit enabled
+            arguments->jit = 1;
+            break;
+        case 'b': // pre-decoded blocks enabled
+            arguments->blocks = 1;
+            break;
         case 'm':
             arguments->mode = atoi(arg);
         case ARGP_KEY_END:
@@ -52,16 +80,20 @@ static struct argp argp = {
 };
 
 int main(int argc, char *argv[]) {
-    struct arguments arguments = {0, 0, "rom.bin"};
+    struct arguments arguments = {0, 0, "rom.bin", "/tmp/emulator101.sock", NULL, 0, 0, 0};
     argp_parse(&argp, argc, argv, 0, 0, &arguments);
 
     char *filename = arguments.target;
     int debug = arguments.debug;
 	int mode   = arguments.mode;
 	if (mode == MODE_CLI)
-	    return run_cli(filename, debug);
+	    return run_cli(filename, debug, arguments.trace, arguments.profile);
 	if (mode == MODE_GUI)
-	    return run_gui(filename, debug);
+	    return run_gui(filename, debug, arguments.trace, arguments.profile, arguments.jit, arguments.blocks);
+	if (mode == MODE_SERVER)
+	    return run_server(arguments.socket, debug);
+	if (mode == MODE_BATCH)
+	    return run_batch(filename, debug, arguments.jit, arguments.blocks);
 	return 0;
 }
 
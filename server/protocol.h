@@ -0,0 +1,64 @@
+#ifndef EMULATOR101_PROTOCOL_H
+#define EMULATOR101_PROTOCOL_H
+
+#include <stdint.h>
+
+// wire format of the emulation server. every message in both directions is a server_header
+// followed by length payload bytes. fields are in host byte order, client and server share
+// the machine since they talk over a unix socket
+
+#define SERVER_MAX_INSTANCES 1024
+#define SERVER_MAX_PAYLOAD (0x10000 + 2)
+// cycles one SERVER_STEP may ask for, about a second of emulated time. every instance shares
+// the poll thread, a longer step would hold the others up
+#define SERVER_MAX_STEP 2000000
+
+enum server_op {
+    SERVER_CREATE = 0, // -> uint16_t instance id
+    SERVER_DESTROY = 1,
+    SERVER_LOAD = 2, // uint16_t offset, image bytes. copied straight into memory, rom included
+    SERVER_STEP = 3, // uint64_t cycles, at most SERVER_MAX_STEP -> struct server_registers after the step
+    SERVER_READ_MEMORY = 4, // uint16_t offset, uint16_t length -> length bytes
+    SERVER_WRITE_MEMORY = 5, // uint16_t offset, bytes
+    SERVER_READ_REGISTERS = 6, // -> struct server_registers
+    SERVER_WRITE_PORT = 7, // uint8_t port, uint8_t value
+    SERVER_FRAME = 8, // -> vram, one bit per pixel in the layout the game writes it
+    SERVER_STATS = 9, // -> struct server_stats
+};
+
+enum server_status {
+    SERVER_OK = 0,
+    SERVER_BAD_OP = 1,
+    SERVER_BAD_INSTANCE = 2,
+    SERVER_BAD_PAYLOAD = 3,
+    SERVER_FULL = 4,
+    SERVER_NO_MEMORY = 5, // the host refused the memory for a new instance
+};
+
+struct server_header {
+    uint8_t op; // enum server_op, echoed in the response
+    uint8_t status; // enum server_status, 0 in requests
+    uint16_t instance;
+    uint32_t length;
+};
+
+struct server_registers {
+    uint8_t a, b, c, d, e, h, l;
+    uint8_t psw; // flags as PUSH PSW stores them
+    uint16_t sp;
+    uint16_t pc;
+    uint8_t int_enable;
+    uint8_t halted; // the cpu sits on a HLT it can never leave
+    uint8_t pad[2];
+    uint64_t cycles;
+};
+
+// memory accesses the instance dropped since it was created
+struct server_stats {
+    uint64_t rom_writes;
+    uint64_t unmapped_writes;
+    uint16_t last_offset; // of the last one
+    uint8_t pad[6];
+};
+
+#endif //EMULATOR101_PROTOCOL_H
@@ -0,0 +1,346 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "server.h"
+#include "protocol.h"
+
+#include "../core/core8080.h"
+#include "../core/io8080.h"
+#include "../core/sched8080.h"
+#include "../core/video8080.h"
+#include "../core/shift8080.h"
+
+#define MEMORY_SIZE 0x10000
+
+struct instance {
+    struct state_8080 *state;
+    struct scheduler_8080 *sched;
+    struct shift_register_8080 shifter;
+    int halted;
+};
+
+// a client that stops reading its replies is no longer read from once this much is queued for it
+#define SERVER_MAX_OUTPUT (4 * (sizeof(struct server_header) + SERVER_MAX_PAYLOAD))
+
+struct client {
+    int fd; // nonblocking, nothing one client does holds up the others
+    uint32_t received;
+    uint8_t buffer[sizeof(struct server_header) + SERVER_MAX_PAYLOAD];
+
+    // replies the socket did not take yet, flushed when poll reports POLLOUT
+    uint8_t *output;
+    size_t output_used;
+    size_t output_capacity;
+};
+
+static struct instance *instances[SERVER_MAX_INSTANCES];
+static struct client *clients[SERVER_MAX_CLIENTS];
+static volatile sig_atomic_t stopping = 0;
+
+static void stop(int signal) {
+    (void) signal;
+    stopping = 1;
+}
+
+// writes as much of client's queued output as the socket takes
+static int flush(struct client *client) {
+    size_t sent = 0;
+
+    while (sent < client->output_used) {
+        ssize_t written = write(client->fd, client->output + sent, client->output_used - sent);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (written <= 0) return -1;
+        sent += written;
+    }
+    memmove(client->output, client->output + sent, client->output_used - sent);
+    client->output_used -= sent;
+    return 0;
+}
+
+static int queue(struct client *client, const void *data, size_t length) {
+    if (length == 0) return 0;
+    if (client->output_used + length > client->output_capacity) {
+        size_t capacity = client->output_capacity ? client->output_capacity : 4096;
+        while (capacity < client->output_used + length) capacity *= 2;
+        uint8_t *output = realloc(client->output, capacity);
+        if (output == NULL) return -1;
+        client->output = output;
+        client->output_capacity = capacity;
+    }
+    memcpy(client->output + client->output_used, data, length);
+    client->output_used += length;
+    return 0;
+}
+
+static int respond(struct client *client, struct server_header *request, uint8_t status, const void *payload,
+                   uint32_t length) {
+    struct server_header header = {request->op, status, request->instance, length};
+    if (queue(client, &header, sizeof(header)) || queue(client, payload, length)) return -1;
+    return flush(client);
+}
+
+// NULL when the host refuses the memory
+static struct instance *make_instance() {
+    struct instance *instance = calloc(1, sizeof(struct instance));
+
+    if (instance == NULL) return NULL;
+    instance->state = make_state(MEMORY_SIZE, 0);
+    instance->sched = make_scheduler();
+    if (instance->state == NULL || instance->sched == NULL) {
+        if (instance->state) free_state(instance->state);
+        free(instance->sched);
+        free(instance);
+        return NULL;
+    }
+    instance->state->io = make_io(256);
+    shift8080_install(instance->state->io, &instance->shifter);
+    video8080_install_interrupts(instance->sched, instance->state);
+    return instance;
+}
+
+static void free_instance(struct instance *instance) {
+    free(instance->sched);
+    free_io(instance->state->io);
+    free_state(instance->state);
+    free(instance);
+}
+
+static void read_registers(struct instance *instance, struct server_registers *registers) {
+    struct state_8080 *state = instance->state;
+
+    memset(registers, 0, sizeof(*registers));
+    registers->a = state->a;
+    registers->b = state->b;
+    registers->c = state->c;
+    registers->d = state->d;
+    registers->e = state->e;
+    registers->h = state->h;
+    registers->l = state->l;
+    registers->psw = pack_flags(state);
+    registers->sp = state->sp;
+    registers->pc = state->pc;
+    registers->int_enable = state->int_enable;
+    registers->halted = instance->halted;
+    registers->cycles = state->cycles;
+}
+
+static uint16_t read_u16(const uint8_t *payload) {
+    uint16_t value;
+    memcpy(&value, payload, sizeof(value));
+    return value;
+}
+
+// runs one complete request, returns -1 when the client has to be dropped
+static int handle(struct client *client, int debug) {
+    struct server_header *request = (struct server_header *) client->buffer;
+    uint8_t *payload = client->buffer + sizeof(struct server_header);
+    struct instance *instance = request->instance < SERVER_MAX_INSTANCES ? instances[request->instance] : NULL;
+    struct server_registers registers;
+    uint32_t offset, length;
+
+    if (debug) printf("client %d: op %d instance %d length %u\n", client->fd, request->op, request->instance, request->length);
+
+    if (request->op == SERVER_CREATE) {
+        for (uint16_t id = 0; id < SERVER_MAX_INSTANCES; id++) {
+            if (instances[id]) continue;
+            instances[id] = make_instance();
+            if (instances[id] == NULL) return respond(client, request, SERVER_NO_MEMORY, NULL, 0);
+            return respond(client, request, SERVER_OK, &id, sizeof(id));
+        }
+        return respond(client, request, SERVER_FULL, NULL, 0);
+    }
+    if (instance == NULL) return respond(client, request, SERVER_BAD_INSTANCE, NULL, 0);
+
+    switch (request->op) {
+        case SERVER_DESTROY:
+            free_instance(instance);
+            instances[request->instance] = NULL;
+            return respond(client, request, SERVER_OK, NULL, 0);
+        case SERVER_LOAD:
+            if (request->length < 2) break;
+            offset = read_u16(payload);
+            length = request->length - 2;
+            if (offset + length > MEMORY_SIZE) break;
+            memcpy(instance->state->memory + offset, payload + 2, length);
+            memset(instance->state->vram_dirty, 0xff, sizeof(instance->state->vram_dirty));
+            return respond(client, request, SERVER_OK, NULL, 0);
+        case SERVER_STEP: {
+            uint64_t cycles;
+            if (request->length != sizeof(cycles)) break;
+            memcpy(&cycles, payload, sizeof(cycles));
+            if (cycles > SERVER_MAX_STEP) break;
+            instance->halted = cpu_run_scheduled(instance->state, instance->sched, cycles);
+            read_registers(instance, &registers);
+            return respond(client, request, SERVER_OK, &registers, sizeof(registers));
+        }
+        case SERVER_READ_MEMORY:
+            if (request->length != 4) break;
+            offset = read_u16(payload);
+            length = read_u16(payload + 2);
+            if (offset + length > MEMORY_SIZE) break;
+            return respond(client, request, SERVER_OK, instance->state->memory + offset, length);
+        case SERVER_WRITE_MEMORY:
+            if (request->length < 2) break;
+            offset = read_u16(payload);
+            length = request->length - 2;
+            if (offset + length > MEMORY_SIZE) break;
+            for (uint32_t i = 0; i < length; i++) {
+                core8080_write_byte(instance->state, offset + i, payload[2 + i]);
+            }
+            return respond(client, request, SERVER_OK, NULL, 0);
+        case SERVER_READ_REGISTERS:
+            read_registers(instance, &registers);
+            return respond(client, request, SERVER_OK, &registers, sizeof(registers));
+        case SERVER_WRITE_PORT:
+            if (request->length != 2) break;
+            io8080_write_port(instance->state->io, payload[0], payload[1]);
+            return respond(client, request, SERVER_OK, NULL, 0);
+        case SERVER_FRAME:
+            // the 1bpp vram is 7k against 224k for a rendered frame, clients rotate and color it
+            return respond(client, request, SERVER_OK, instance->state->memory + VRAM_ADDRESS, VRAM_SIZE);
+        case SERVER_STATS: {
+            struct memory_stats_8080 memory_stats;
+            struct server_stats stats = {0};
+            memory8080_stats(instance->state, &memory_stats);
+            stats.rom_writes = memory_stats.rom_writes;
+            stats.unmapped_writes = memory_stats.unmapped_writes;
+            stats.last_offset = memory_stats.last_offset;
+            return respond(client, request, SERVER_OK, &stats, sizeof(stats));
+        }
+        default:
+            return respond(client, request, SERVER_BAD_OP, NULL, 0);
+    }
+    return respond(client, request, SERVER_BAD_PAYLOAD, NULL, 0);
+}
+
+// reads what is there of the current message, handling it once complete.
+// returns -1 when the client hung up or sent something unusable
+static int receive(struct client *client, int debug) {
+    struct server_header *header = (struct server_header *) client->buffer;
+    uint32_t wanted = sizeof(struct server_header);
+
+    if (client->received >= sizeof(struct server_header)) {
+        if (header->length > SERVER_MAX_PAYLOAD) return -1;
+        wanted += header->length;
+    }
+
+    ssize_t got = read(client->fd, client->buffer + client->received, wanted - client->received);
+    if (got < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    if (got <= 0) return -1;
+    client->received += got;
+
+    if (client->received == sizeof(struct server_header) && header->length > 0) {
+        return header->length > SERVER_MAX_PAYLOAD ? -1 : 0;
+    }
+    if (client->received < wanted) return 0;
+
+    client->received = 0;
+    return handle(client, debug);
+}
+
+static int listen_on(char *socket_path) {
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0) return -1;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+    unlink(socket_path);
+
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) || listen(fd, SOMAXCONN)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void accept_client(int listener, int debug) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0) return;
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK)) {
+        close(fd);
+        return;
+    }
+
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        if (clients[i]) continue;
+        clients[i] = calloc(1, sizeof(struct client));
+        if (clients[i] == NULL) break;
+        clients[i]->fd = fd;
+        if (debug) printf("client %d: connected\n", fd);
+        return;
+    }
+    close(fd);
+}
+
+static void drop_client(int i, int debug) {
+    if (debug) printf("client %d: disconnected\n", clients[i]->fd);
+    close(clients[i]->fd);
+    free(clients[i]->output);
+    free(clients[i]);
+    clients[i] = NULL;
+}
+
+int run_server(char *socket_path, int debug) {
+    struct pollfd fds[SERVER_MAX_CLIENTS + 1];
+    int owners[SERVER_MAX_CLIENTS + 1];
+    int listener = listen_on(socket_path);
+
+    if (listener < 0) {
+        printf("Cannot Listen On %s: %s\n", socket_path, strerror(errno));
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    printf("listening on %s\n", socket_path);
+
+    while (!stopping) {
+        int count = 1;
+
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+            if (!clients[i]) continue;
+            fds[count].fd = clients[i]->fd;
+            fds[count].events = clients[i]->output_used < SERVER_MAX_OUTPUT ? POLLIN : 0;
+            if (clients[i]->output_used) fds[count].events |= POLLOUT;
+            owners[count] = i;
+            count++;
+        }
+
+        if (poll(fds, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 1; i < count; i++) {
+            struct client *client = clients[owners[i]];
+            int failed = 0;
+
+            if (fds[i].revents & POLLOUT) failed = flush(client);
+            if (!failed && fds[i].revents & (POLLIN | POLLHUP | POLLERR)) failed = receive(client, debug);
+            if (failed) drop_client(owners[i], debug);
+        }
+        if (fds[0].revents & POLLIN) accept_client(listener, debug);
+    }
+
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        if (clients[i]) drop_client(i, debug);
+    }
+    for (int i = 0; i < SERVER_MAX_INSTANCES; i++) {
+        if (instances[i]) free_instance(instances[i]);
+    }
+    close(listener);
+    unlink(socket_path);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef EMULATOR101_SERVER_H
+#define EMULATOR101_SERVER_H
+
+#define SERVER_MAX_CLIENTS 256
+
+// hosts any number of independent machines for clients on a unix socket, see protocol.h.
+// instances are not tied to the connection that created them, any client can drive any of them
+int run_server(char *socket_path, int debug);
+
+#endif //EMULATOR101_SERVER_H
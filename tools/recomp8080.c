@@ -0,0 +1,367 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "core/core8080.h"
+#include "core/cycles8080.h"
+#include "core/disassembler.h"
+#include "core/util.h"
+#include "core/rom8080.h"
+
+// recomp8080 rom > recompiled.c
+// translates rom, a single image loaded at 0x0000 or a manifest, to a C file defining recompiled_rom. every basic block
+// reachable from reset and the rst vectors becomes a labelled run of C statements, jumps
+// between blocks are gotos and anything else, computed jumps included, goes through a
+// switch on pc. pcs without a block and blocks on pages written since start are stepped
+// through cpu_update. `make emulator101-recomp ROM=rom` builds the emulator with it
+
+#define IMAGE_MAX 0x10000
+#define BLOCK_MAX 64 // instructions, so a block never spans more than two pages
+
+static uint8_t image[IMAGE_MAX + 2];
+static uint32_t size;
+
+static uint8_t is_start[IMAGE_MAX]; // some path enters a block here
+static uint8_t is_block[IMAGE_MAX]; // a block was emitted for this pc
+
+static const char *reg[8] = {"b", "c", "d", "e", "h", "l", "M", "a"};
+static const char *alu[8] = {"ADD", "ADC", "SUB", "SBB", "ANA", "XRA", "ORA", "CMP"};
+static const char *pair_hi[4] = {"b", "d", "h", "sp"};
+static const char *pair_lo[4] = {"c", "e", "l", "sp"};
+static const char *condition[8] = {
+        "!FLAGS_READ(state).z", "FLAGS_READ(state).z", "!FLAGS_READ(state).cy", "FLAGS_READ(state).cy",
+        "!FLAGS_READ(state).p", "FLAGS_READ(state).p", "!FLAGS_READ(state).s", "FLAGS_READ(state).s",
+};
+
+static int length_of(uint8_t op) {
+    char mnemonic[DISASSEMBLE_LINE_MAX + 1];
+    return disassemble_8080_opcode(mnemonic, sizeof(mnemonic), op);
+}
+
+// DAA and HLT are left to cpu_update
+static int translatable(uint8_t op) {
+    return op != 0x27 && op != 0x76;
+}
+
+// jumps, calls, returns, rst and pchl, the last instruction of a block
+static int ends_block(uint8_t op) {
+    if ((op & 0xc0) != 0xc0) return 0;
+    if ((op & 0x07) == 0x00 || (op & 0x07) == 0x02 || (op & 0x07) == 0x04 || (op & 0x07) == 0x07) return 1;
+    return op == 0xc3 || op == 0xc9 || op == 0xcb || op == 0xcd || op == 0xd9 ||
+           op == 0xdd || op == 0xe9 || op == 0xed || op == 0xfd;
+}
+
+static int is_jump(uint8_t op) {
+    return op == 0xc3 || op == 0xcb || (op & 0xc7) == 0xc2;
+}
+
+static int is_call(uint8_t op) {
+    return op == 0xcd || op == 0xdd || op == 0xed || op == 0xfd || (op & 0xc7) == 0xc4;
+}
+
+static int fits(uint32_t pc) {
+    return pc < size && pc + length_of(image[pc]) <= size;
+}
+
+static uint16_t operand(uint32_t pc) {
+    return image[pc + 2] << 8 | image[pc + 1];
+}
+
+static void mark(uint32_t *work, int *n_work, uint32_t pc) {
+    if (pc >= size || is_start[pc]) return;
+    is_start[pc] = 1;
+    work[(*n_work)++] = pc;
+}
+
+// every pc a block can start at: the entry points, branch targets, return addresses and
+// whatever follows an instruction left to cpu_update
+static void discover() {
+    uint32_t *work = malloc(IMAGE_MAX * sizeof(uint32_t));
+    int n_work = 0;
+
+    for (uint32_t vector = 0; vector <= 0x38; vector += 8) mark(work, &n_work, vector);
+    while (n_work > 0) {
+        uint32_t pc = work[--n_work];
+
+        for (int n = 1; fits(pc); n++) {
+            uint8_t op = image[pc];
+            uint32_t next = pc + length_of(op);
+
+            if (n % BLOCK_MAX == 0) mark(work, &n_work, next);
+
+            if (!translatable(op)) {
+                mark(work, &n_work, next);
+                break;
+            }
+            if (is_jump(op) || is_call(op)) mark(work, &n_work, operand(pc));
+            if ((op & 0xc7) == 0xc7) mark(work, &n_work, op & 0x38);
+            if (ends_block(op)) {
+                if (op != 0xc3 && op != 0xcb && op != 0xc9 && op != 0xd9 && op != 0xe9) {
+                    mark(work, &n_work, next);
+                }
+                break;
+            }
+            pc = next;
+        }
+    }
+    free(work);
+}
+
+// the C of the instruction being translated
+static char code[512];
+static size_t code_used;
+
+static void put(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    code_used += vsnprintf(code + code_used, sizeof(code) - code_used, format, args);
+    va_end(args);
+}
+
+// the C for an instruction that does not end a block. returns 1 when it may write memory
+static int emit_instruction(uint32_t pc) {
+    uint8_t op = image[pc];
+    uint8_t d8 = image[pc + 1];
+    uint16_t d16 = operand(pc);
+    int dst = (op >> 3) & 7, src = op & 7, pair = (op >> 4) & 3;
+
+    if (op >= 0x40 && op < 0x80) { // MOV
+        if (dst == 6) {
+            put("WRITE(HL, %s);", reg[src]);
+            return 1;
+        }
+        if (src == 6) put("%s = READ(HL);", reg[dst]);
+        else if (src != dst) put("%s = %s;", reg[dst], reg[src]);
+        return 0;
+    }
+    if (op >= 0x80 && op < 0xc0) { // ADD ... CMP
+        put("%s(%s);", alu[dst], src == 6 ? "READ(HL)" : reg[src]);
+        return 0;
+    }
+    if ((op & 0xc7) == 0xc6) { // ADI ... CPI
+        put("%s(0x%02x);", alu[dst], d8);
+        return 0;
+    }
+    if ((op & 0xc7) == 0x06) { // MVI
+        if (dst == 6) {
+            put("WRITE(HL, 0x%02x);", d8);
+            return 1;
+        }
+        put("%s = 0x%02x;", reg[dst], d8);
+        return 0;
+    }
+    if ((op & 0xc6) == 0x04) { // INR, DCR
+        const char *name = op & 1 ? "DCR" : "INR";
+        if (dst != 6) {
+            put("%s(%s);", name, reg[dst]);
+            return 0;
+        }
+        put("value = READ(HL) %s 1; WRITE(HL, value); FLAGS_%s(state, value);", op & 1 ? "-" : "+", name);
+        return 1;
+    }
+    if ((op & 0xcf) == 0x01) { // LXI
+        if (pair == 3) put("sp = 0x%04x;", d16);
+        else put("%s = 0x%02x; %s = 0x%02x;", pair_lo[pair], d16 & 0xff, pair_hi[pair], d16 >> 8);
+        return 0;
+    }
+    if ((op & 0xc7) == 0x03) { // INX, DCX
+        if (pair == 3) put("sp %s= 1;", op & 8 ? "-" : "+");
+        else put("%s(%s, %s);", op & 8 ? "DCX" : "INX", pair_hi[pair], pair_lo[pair]);
+        return 0;
+    }
+    if ((op & 0xcf) == 0x09) { // DAD
+        if (pair == 3) put("DAD(sp);");
+        else put("DAD(WORD(%s, %s));", pair_hi[pair], pair_lo[pair]);
+        return 0;
+    }
+    if ((op & 0xcb) == 0xc1) { // PUSH, POP
+        const char *hi = pair == 3 ? "a" : pair_hi[pair], *lo = pair == 3 ? "pack_flags(state)" : pair_lo[pair];
+        if (op & 4) {
+            put("PUSH(%s, %s);", hi, lo);
+            return 1;
+        }
+        if (pair == 3) put("POP(a, tmp); unpack_flags(state, tmp);");
+        else put("POP(%s, %s);", hi, lo);
+        return 0;
+    }
+
+    switch (op) {
+        case 0x00: case 0x08: case 0x10: case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+            return 0;
+        case 0x02: put("WRITE(WORD(b, c), a);"); return 1;
+        case 0x12: put("WRITE(WORD(d, e), a);"); return 1;
+        case 0x0a: put("a = READ(WORD(b, c));"); return 0;
+        case 0x1a: put("a = READ(WORD(d, e));"); return 0;
+        case 0x07: put("tmp = (a & 0x80) != 0; a = a << 1 | tmp; FLAGS(state).cy = tmp;"); return 0;
+        case 0x0f: put("tmp = a & 0x1; a = (a >> 1) | (tmp << 7); FLAGS(state).cy = tmp;"); return 0;
+        case 0x17: put("tmp = (a & 0x80) != 0; a = a << 1 | FLAGS_READ(state).cy; FLAGS(state).cy = tmp;"); return 0;
+        case 0x1f: put("tmp = a & 0x1; a = (a >> 1) | (FLAGS_READ(state).cy << 7); FLAGS(state).cy = tmp;"); return 0;
+        case 0x22: put("WRITE(0x%04x, l); WRITE(0x%04x, h);", d16, (uint16_t) (d16 + 1)); return 1;
+        case 0x2a: put("l = READ(0x%04x); h = READ(0x%04x);", d16, (uint16_t) (d16 + 1)); return 0;
+        case 0x2f: put("a = ~a;"); return 0;
+        case 0x32: put("WRITE(0x%04x, a);", d16); return 1;
+        case 0x3a: put("a = READ(0x%04x);", d16); return 0;
+        case 0x37: put("FLAGS(state).cy = 1;"); return 0;
+        case 0x3f: put("FLAGS(state).cy = !FLAGS(state).cy;"); return 0;
+        case 0xd3: put("state->a = a; core8080_io_write(state, 0x%02x);", d8); return 0;
+        case 0xdb: put("core8080_io_read(state, 0x%02x); a = state->a;", d8); return 0;
+        case 0xe3: put("POP(value, tmp); PUSH(h, l); h = value; l = tmp;"); return 1;
+        case 0xeb: put("value = h; h = d; d = value; tmp = l; l = e; e = tmp;"); return 0;
+        case 0xf3: put("state->int_enable = 0;"); return 0;
+        case 0xfb: put("state->int_enable = 1;"); return 0;
+        case 0xf9: put("sp = HL;"); return 0;
+        default:
+            fprintf(stderr, "no translation for opcode %02x\n", op);
+            exit(1);
+    }
+}
+
+static void emit_goto(uint16_t target) {
+    if (is_block[target]) put("goto b_%04x;", target);
+    else put("{ pc = 0x%04x; goto dispatch; }", target);
+}
+
+// the C for the instruction ending a block
+static void emit_terminator(uint32_t pc) {
+    uint8_t op = image[pc];
+    uint16_t target = operand(pc), next = pc + length_of(op);
+    const char *cond = condition[(op >> 3) & 7];
+
+    if (op == 0xc3 || op == 0xcb) {
+        emit_goto(target);
+    } else if (is_jump(op)) {
+        put("if (%s) ", cond);
+        emit_goto(target);
+        put("\n    ");
+        emit_goto(next);
+    } else if (op == 0xe9) {
+        put("pc = HL; goto dispatch;");
+    } else if ((op & 0xc7) == 0xc7) {
+        put("PUSH(0x%02x, 0x%02x); ", next >> 8, next & 0xff);
+        emit_goto(op & 0x38);
+    } else if (is_call(op)) {
+        if ((op & 0xc7) == 0xc4) put("if (%s) { cycles += CYCLES_8080_TAKEN; ", cond);
+        put("PUSH(0x%02x, 0x%02x); ", next >> 8, next & 0xff);
+        emit_goto(target);
+        if ((op & 0xc7) == 0xc4) {
+            put(" }\n    ");
+            emit_goto(next);
+        }
+    } else {
+        if ((op & 0xc7) == 0xc0) put("if (%s) { cycles += CYCLES_8080_TAKEN; ", cond);
+        put("POP(value, tmp); pc = WORD(value, tmp); goto dispatch;");
+        if ((op & 0xc7) == 0xc0) {
+            put(" }\n    ");
+            emit_goto(next);
+        }
+    }
+}
+
+// the instructions of the block at start: up to and including a jump, call or return, up to
+// an instruction left to cpu_update, or up to the next block start
+static int block_length(uint32_t start, uint32_t *pcs) {
+    int n = 0;
+
+    for (uint32_t pc = start; fits(pc) && translatable(image[pc]); pc += length_of(image[pc])) {
+        if (n > 0 && is_start[pc]) break;
+        pcs[n++] = pc;
+        if (ends_block(image[pc])) break;
+    }
+    return n;
+}
+
+static void emit_block(FILE *out, uint32_t start, uint32_t *pcs, int n) {
+    char line[DISASSEMBLE_LINE_MAX + 1];
+    uint32_t before[n + 1];
+    uint32_t last = pcs[n - 1], end = last + length_of(image[last]);
+
+    before[0] = 0;
+    for (int i = 0; i < n; i++) before[i + 1] = before[i] + cycles_8080[image[pcs[i]]];
+
+    fprintf(out, "\nb_%04x:\n", start);
+    fprintf(out, "    pc = 0x%04x;\n", start);
+    fprintf(out, "    RECOMP_ENTER(%d, %u, %u, 0x%02x, 0x%02x);\n", n, before[n - 1], before[n],
+            start >> 8, (end - 1) >> 8);
+    for (int i = 0; i < n; i++) {
+        uint32_t pc = pcs[i];
+        uint16_t next = pc + length_of(image[pc]);
+
+        disassemble_8080_to(line, sizeof(line), image, pc);
+        code_used = 0;
+        if (i == n - 1 && ends_block(image[pc])) {
+            emit_terminator(pc);
+        } else if (emit_instruction(pc) && i < n - 1) {
+            put("\n    RECOMP_STALE(0x%04x, %d, %u);", next, n - 1 - i, before[n] - before[i + 1]);
+        }
+        fprintf(out, "    // %s\n", line);
+        if (code_used) fprintf(out, "    %s\n", code);
+    }
+    if (!ends_block(image[last])) {
+        code_used = 0;
+        emit_goto(end);
+        fprintf(out, "    %s\n", code);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("usage: %s rom > recompiled.c\n", argv[0]);
+        return 1;
+    }
+
+    // loaded the way the emulator loads it, so manifests translate as well
+    struct rom_8080 *rom = open_rom(argv[1]);
+    struct state_8080 *state = make_state(IMAGE_MAX, 0);
+    if (rom == NULL || rom8080_load(rom, state)) {
+        fprintf(stderr, "Cannot Read ROM %s\n", argv[1]);
+        return 1;
+    }
+    for (int i = 0; i < rom->n_segments; i++) {
+        uint32_t end = rom->segments[i].offset + rom->segments[i].size;
+        if (end > size) size = end;
+    }
+    memcpy(image, state->memory, size);
+    close_rom(rom);
+    free_state(state);
+
+    discover();
+    uint32_t *pcs = malloc(IMAGE_MAX * sizeof(uint32_t));
+    for (uint32_t pc = 0; pc < size; pc++) is_block[pc] = is_start[pc] && block_length(pc, pcs) > 0;
+
+    FILE *out = stdout;
+    fprintf(out, "// translated from %s by recomp8080, do not edit\n\n", argv[1]);
+    fprintf(out, "#include \"core/core8080.h\"\n#include \"core/cycles8080.h\"\n");
+    fprintf(out, "#include \"core/ops8080.h\"\n#include \"core/recomp8080.h\"\n\n");
+    fprintf(out, "#define WRITE(offset, value) core8080_write_byte(state, (offset), (value))\n\n");
+    fprintf(out, "static int run(struct state_8080 *state, long n_instructions, uint64_t cycle_limit) {\n");
+    fprintf(out, "    struct recomp_8080 *recomp = state->recomp;\n");
+    fprintf(out, "    uint8_t a, b, c, d, e, h, l;\n    uint16_t sp, pc;\n    uint16_t w;\n    uint32_t sum;\n");
+    fprintf(out, "    uint8_t value, tmp;\n    uint64_t cycles;\n    long remaining = n_instructions;\n");
+    fprintf(out, "    int halted = 0;\n\n    RELOAD();\n\n");
+
+    fprintf(out, "dispatch:\n");
+    fprintf(out, "    if (remaining <= 0 || cycles >= cycle_limit) goto done;\n");
+    fprintf(out, "    switch (pc) {\n");
+    for (uint32_t pc = 0; pc < size; pc++) {
+        if (is_block[pc]) fprintf(out, "        case 0x%04x: goto b_%04x;\n", pc, pc);
+    }
+    fprintf(out, "        default: goto slow;\n    }\n\n");
+
+    fprintf(out, "    // one instruction through the interpreter: no block here, the block does not fit the\n");
+    fprintf(out, "    // budget or was written over\n");
+    fprintf(out, "slow:\n");
+    fprintf(out, "    if (remaining <= 0 || cycles >= cycle_limit) goto done;\n");
+    fprintf(out, "    remaining -= 1;\n    SPILL();\n    halted = cpu_update(state);\n    RELOAD();\n");
+    fprintf(out, "    recomp->stale = 0;\n    if (halted) goto done;\n    goto dispatch;\n");
+
+    for (uint32_t pc = 0; pc < size; pc++) {
+        if (is_block[pc]) emit_block(out, pc, pcs, block_length(pc, pcs));
+    }
+
+    fprintf(out, "\ndone:\n    SPILL();\n    return halted;\n}\n\n");
+    fprintf(out, "const struct recompiled_8080 recompiled_rom = {0x%016llxULL, 0x%x, run};\n",
+            (unsigned long long) hash_bytes(image, size), size);
+    free(pcs);
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/trace8080.h"
+#include "core/disassembler.h"
+
+// tracedump trace_file [records]
+// prints the last records (default all) of a trace written with --trace, oldest first.
+// `make tracedump` builds it
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("usage: %s trace_file [records]\n", argv[0]);
+        return 1;
+    }
+
+    struct trace_8080 *trace = open_trace(argv[1]);
+    if (trace == NULL) {
+        printf("Cannot Read Trace %s\n", argv[1]);
+        return 1;
+    }
+
+    uint64_t capacity = trace->header->capacity;
+    uint64_t count = trace->head < capacity ? trace->head : capacity;
+    if (argc > 2 && strtoull(argv[2], NULL, 0) < count) count = strtoull(argv[2], NULL, 0);
+
+    // the disassembler reads from a memory image, so every record's bytes are put back at their pc.
+    // the slack covers an instruction that wraps past 0xffff
+    uint8_t *memory = calloc(0x10000 + 2, 1);
+
+    for (uint64_t i = trace->head - count; i < trace->head; i++) {
+        struct trace_record_8080 *record = &trace->records[i & trace->mask];
+        char instruction[DISASSEMBLE_LINE_MAX + 1];
+
+        memcpy(&memory[record->pc], record->bytes, sizeof(record->bytes));
+        disassemble_8080_to(instruction, sizeof(instruction), memory, record->pc);
+        printf("%12llu a=%02x b=%02x c=%02x d=%02x e=%02x h=%02x l=%02x psw=%02x sp=%04x  %s\n",
+               (unsigned long long) record->cycle, record->a, record->b, record->c, record->d,
+               record->e, record->h, record->l, record->psw, record->sp, instruction);
+    }
+
+    free(memory);
+    free_trace(trace);
+    return 0;
+}